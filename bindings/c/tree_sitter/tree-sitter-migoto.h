@@ -1,6 +1,8 @@
 #ifndef TREE_SITTER_MIGOTO_H_
 #define TREE_SITTER_MIGOTO_H_
 
+#include <stdint.h>
+
 typedef struct TSLanguage TSLanguage;
 
 #ifdef __cplusplus
@@ -9,6 +11,27 @@ extern "C" {
 
 const TSLanguage *tree_sitter_migoto(void);
 
+#ifdef TREE_SITTER_MIGOTO_SCANNER_STATS
+/// Work done by the external scanner for one external token.
+/// Collected only when the library is built with the TREE_SITTER_MIGOTO_SCANNER_STATS CMake option, which also
+/// defines the macro for targets linking the library and in its pkg-config Cflags, so these declarations only
+/// exist where the functions do.
+typedef struct {
+  const char *name;                 // the token's name in the `externals` list of grammar.js
+  uint64_t invocations;             // scanner calls that searched for this token
+  uint64_t successes;               // tokens of this type the scanner returned
+  uint64_t characters;              // characters consumed or skipped while searching for it
+  uint64_t section_header_searches; // section name searches run while searching for it
+} TSMigotoScannerStats;
+
+/// Copies the counters of up to `count` external tokens into `stats`, in `externals` order,
+/// and returns the number of external tokens. The counters are process-wide and not synchronized.
+uint32_t tree_sitter_migoto_scanner_stats(TSMigotoScannerStats *stats, uint32_t count);
+
+/// Zeroes the external scanner counters.
+void tree_sitter_migoto_scanner_stats_reset(void);
+#endif // TREE_SITTER_MIGOTO_SCANNER_STATS
+
 #ifdef __cplusplus
 }
 #endif
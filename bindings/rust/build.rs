@@ -33,6 +33,9 @@ fn main() {
     if scanner_path.exists() {
         c_config.file(&scanner_path);
         println!("cargo:rerun-if-changed={}", scanner_path.to_str().unwrap());
+
+        let scanner_tokens_path = src_dir.join("scanner_tokens.h");
+        println!("cargo:rerun-if-changed={}", scanner_tokens_path.to_str().unwrap());
     }
 
     c_config.compile("tree-sitter-migoto");
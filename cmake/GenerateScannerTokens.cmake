@@ -0,0 +1,40 @@
+# Generates the external token enum of src/scanner.c from the `externals` list in grammar.js,
+# so the scanner's token numbering always matches the one tree-sitter assigns.
+#
+# Usage: cmake -DGRAMMAR=grammar.js -DOUTPUT=src/scanner_tokens.h -P cmake/GenerateScannerTokens.cmake
+
+file(READ "${GRAMMAR}" grammar)
+
+string(REGEX MATCH "externals: \\$ => \\[[^]]*\\]" externals "${grammar}")
+if(NOT externals)
+  message(FATAL_ERROR "No externals list found in ${GRAMMAR}")
+endif()
+
+string(REGEX MATCHALL "\\$\\.[A-Za-z0-9_]+" tokens "${externals}")
+
+set(enum "")
+set(names "")
+foreach(token IN LISTS tokens)
+  string(SUBSTRING "${token}" 2 -1 name)
+  string(REGEX REPLACE "^_" "" constant "${name}")
+  string(TOUPPER "${constant}" constant)
+  string(APPEND enum "    ${constant},\n")
+  string(APPEND names "    \"${name}\",\n")
+endforeach()
+
+file(WRITE "${OUTPUT}"
+"// Generated from the externals list in grammar.js by cmake/GenerateScannerTokens.cmake, do not edit
+
+#ifndef TREE_SITTER_MIGOTO_SCANNER_TOKENS_H_
+#define TREE_SITTER_MIGOTO_SCANNER_TOKENS_H_
+
+typedef enum {
+${enum}} TokenType;
+
+#ifdef TREE_SITTER_MIGOTO_SCANNER_STATS
+static const char *const TOKEN_NAMES[] = {
+${names}};
+#endif
+
+#endif // TREE_SITTER_MIGOTO_SCANNER_TOKENS_H_
+")
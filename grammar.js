@@ -31,22 +31,46 @@ const namespace_regex = /[^\s>\\|\/<?:*="$][^>\\|\/<?:*=$\r\n]+(?:[\\\/][^>\\|\/
 const path_regex = /(?:(?:(?:[a-z]:|\.[\.]?)[\\\/])?(?:\.\.|[^\s>\\|\/<?:*"$][^>\\|\/<?:*"$\r\n]*)(?:[\\\/](?:\.\.|[^\s>\\|\/<?:*"$][^>\\|\/<?:*"$\r\n]*))+)/i
 const file_regex = /[^\s>\\|\/<?:*"$\r\n][^>\\|\/<?:*"$\r\n]*\.[a-z0-9_\-]*[a-z_\-][a-z0-9_\-]*/i // numbers in file extensions are excluded so that lists of floats as setting values are allowed
 
-const custom_shader_keys_with_brackets = new RustRegex(`(?xi)(blend_factor\\[[0-3]\\]|(?:blend|alpha|mask)(?:\\[[0-7]\\])?)`)
+/**
+ * Returns every combination of one word from each group, joined in order
+ * @param {...string[]} groups
+ * @returns {string[]}
+ */
+const combine = (...groups) => groups.reduce(
+  (words, group) => words.flatMap(word => group.map(part => word + part)),
+  ['']
+);
 
-const setting_section_directory_value_keys = new RustRegex(`(?xi)(
-  (override|cache|storage)_directory|include(_recursive)? |
-  exclude_recursive
-)`)
+/**
+ * Returns a choice of one case-insensitive token per word.
+ * Every word matched by `fixed_value` then becomes a keyword of its own, so the main lexer only has to lex the
+ * word token and the keyword table classifies it. A single regex alternation would overlap the other keys that
+ * spell the same word, and tree-sitter leaves overlapping tokens out of keyword extraction. Words are lowercased so
+ * that every rule spelling a word, e.g. the `Stereo` header and the `stereo` resource modifier, shares its token.
+ * @param {...string} words
+ * @returns {ChoiceRule}
+ */
+const keywords = (...words) => choice(...words.map(word => new RegExp(word.toLowerCase(), 'i')));
 
-const setting_section_key_binding_keys = new RustRegex(`(?xi)(
-  (?:done_|toggle_)hunting | next_marking_mode | mark_snapshot |
-  (?:previous|next|mark)_(?:pixel|vertex|compute|geometry|domain|hull)shader |
-  (?:previous|next|mark)_(?:index|vertex)buffer | (?:previous|next)_(?:index|vertex)buffer_slot |
-  (?:previous|next|mark)_rendertarget |
-  take_screenshot | reload_fixes | (?:reload|wipe_user)_config | show_original |
-  monitor_performance | freeze_performance_monitor | tune[123]_(?:up|down) |
-  analyse_frame | toggle_full_screen | force_full_screen_on_key
-)`)
+const custom_shader_keys_with_brackets = /(?:blend_factor\[[0-3]\]|(?:blend|alpha|mask)\[[0-7]\])/i
+
+const custom_shader_keys = ['blend', 'alpha', 'mask']
+
+const setting_section_directory_value_keys = [
+  ...combine(['override', 'cache', 'storage'], ['_directory']),
+  'include', 'include_recursive', 'exclude_recursive'
+]
+
+const setting_section_key_binding_keys = [
+  'done_hunting', 'toggle_hunting', 'next_marking_mode', 'mark_snapshot',
+  ...combine(['previous', 'next', 'mark'], ['_'], ['pixel', 'vertex', 'compute', 'geometry', 'domain', 'hull'], ['shader']),
+  ...combine(['previous', 'next', 'mark'], ['_'], ['index', 'vertex'], ['buffer']),
+  ...combine(['previous', 'next'], ['_'], ['index', 'vertex'], ['buffer_slot']),
+  ...combine(['previous', 'next', 'mark'], ['_rendertarget']),
+  'take_screenshot', 'reload_fixes', 'reload_config', 'wipe_user_config', 'show_original',
+  'monitor_performance', 'freeze_performance_monitor', ...combine(['tune'], ['1', '2', '3'], ['_up', '_down']),
+  'analyse_frame', 'toggle_full_screen', 'force_full_screen_on_key'
+]
 
 const resource_type_values = new RustRegex(`(?xi)(
   (?:RW)?(?:Append|Consume)?StructuredBuffer|(?:RW)?(?:ByteAddress)?Buffer|(?:RW)?Texture[123]D|TextureCube
@@ -145,6 +169,8 @@ export default grammar({
     $._setting_statement_key
   ],
 
+  // error_sentinel is only valid in the error state, where the scanner returns it for the rest of a malformed line,
+  // so the parser skips that line as one token
   externals: $ => [
     $._external_line,
     $._section_header_start,
@@ -293,9 +319,9 @@ export default grammar({
 
     _key_section_key: $ => alias($.fixed_value, $.key_section_key),
 
-    _key_section_key_binding_key: _ => token(/key|back/i),
+    _key_section_key_binding_key: _ => keywords('key', 'back'),
 
-    _key_section_listable_key: _ => token(/separation|convergence|(release_)?transition(_type)?/i),
+    _key_section_listable_key: _ => keywords('separation', 'convergence', ...combine(['', 'release_'], ['transition'], ['', '_type'])),
 
     key_section_value: $ => choice(
       field('fixed_value', alias($.fixed_value, $.fixed_key_key_value)),
@@ -484,7 +510,7 @@ export default grammar({
     shader_regex_setting_statement: $ => seq(
       choice(
         seq(
-          field('key', alias(/(shader_model|temps)/i, $.shader_regex_key)),
+          field('key', alias(keywords('shader_model', 'temps'), $.shader_regex_key)),
           '=',
           field('value', repeat1($.free_text))
         ),
@@ -504,7 +530,7 @@ export default grammar({
     setting_section_header: $ => seq(
       '[',
       choice(
-        alias(/(Logging|System|Device|Stereo|Rendering|Hunting|Profile|ConvergenceMap|Loader)/i, $.header_identifier),
+        alias(keywords('Logging', 'System', 'Device', 'Stereo', 'Rendering', 'Hunting', 'Profile', 'ConvergenceMap', 'Loader'), $.header_identifier),
         choice(
           seq(
             alias($._customresource_header_prefix, $.header_prefix),
@@ -551,7 +577,7 @@ export default grammar({
       ),
       // any keys that take KeyBindings, which can also be a single free_text node or single exception_character node
       seq(
-        field('key', alias(setting_section_key_binding_keys, $.setting_statement_key)),
+        field('key', alias(keywords(...setting_section_key_binding_keys), $.setting_statement_key)),
         '=',
         field('value', alias($._specific_key_binding_value, $.setting_statement_value)),
         $._newline
@@ -586,9 +612,9 @@ export default grammar({
 
     _directory_setting_statement_key: $ =>
       // path/file only keys:
-      alias(token(prec(-1, setting_section_directory_value_keys)), $.setting_statement_key),
+      alias(choice(...setting_section_directory_value_keys.map(key => token(prec(-1, new RegExp(key, 'i'))))), $.setting_statement_key),
 
-    _bracketed_setting_statement_key: $ => alias(custom_shader_keys_with_brackets, $.setting_statement_key),
+    _bracketed_setting_statement_key: $ => alias(choice(keywords(...custom_shader_keys), custom_shader_keys_with_brackets), $.setting_statement_key),
 
     _setting_statement_key: $ => alias($.fixed_value, $.setting_statement_key),
 
@@ -607,7 +633,7 @@ export default grammar({
     commandlist_section_header: $ => seq(
       '[',
       choice(
-        alias(/(Present|Clear(?:RenderTarget|DepthStencil)View|ClearUnorderedAccessView(?:Uint|Float))/i, $.header_identifier),
+        alias(keywords('Present', 'ClearRenderTargetView', 'ClearDepthStencilView', 'ClearUnorderedAccessViewUint', 'ClearUnorderedAccessViewFloat'), $.header_identifier),
         seq(
           alias($._commandlist_header_prefix, $.header_prefix),
           alias($._suffixed_commandlist_header, $.header_identifier)
@@ -730,7 +756,7 @@ export default grammar({
       alias($._if, 'if'),
       $._significant_ws,
       field('condition', $.operational_expression),
-      $._newline,
+      $._line_break,
       field('consequence', alias(optional($._block), $.block))
     ),
 
@@ -739,7 +765,7 @@ export default grammar({
       choice(alias($._elif, 'elif'), alias($._elseif, 'else if')),
       $._significant_ws,
       field('condition', $.operational_expression),
-      $._newline,
+      $._line_break,
       field('consequence', alias(optional($._block), $.block))
     ),
 
@@ -793,7 +819,7 @@ export default grammar({
 
     preset_instruction: $ => seq(
       optional($.execution_modifier),
-      alias(/(?:exclude_)?preset/i, $.instruction),
+      alias(keywords('preset', 'exclude_preset'), $.instruction),
       '=',
       choice(
         alias($._useable_section_identifier, $.preset_section_identifier),
@@ -836,7 +862,7 @@ export default grammar({
 
     stereo_instruction: $ => seq(
       optional($.execution_modifier),
-      alias(/(?:separation|convergence)/i, $.instruction),
+      alias(keywords('separation', 'convergence'), $.instruction),
       '=',
       $._static_value,
       $._newline
@@ -899,7 +925,7 @@ export default grammar({
 
     drawindexed_instruction: $ => seq(
       optional($.execution_modifier),
-      alias(/drawindexed(?:instanced)?/i, $.instruction),
+      alias(keywords('drawindexed', 'drawindexedinstanced'), $.instruction),
       '=',
       choice(
         field('fixed_value', alias($.fixed_value, $.draw_instruction_key_value)),
@@ -910,7 +936,7 @@ export default grammar({
 
     drawinstanced_dispatch_instruction: $ => seq(
       optional($.execution_modifier),
-      alias(/(?:drawinstanced|dispatch)/i, $.instruction),
+      alias(keywords('drawinstanced', 'dispatch'), $.instruction),
       '=',
       list_seq($.operational_expression, ','),
       $._newline
@@ -918,7 +944,7 @@ export default grammar({
 
     drawindirect_instruction: $ => seq(
       optional($.execution_modifier),
-      alias(/(?:drawinstanced|drawindexedinstanced|dispatch)indirect/i, $.instruction),
+      alias(keywords(...combine(['drawinstanced', 'drawindexedinstanced', 'dispatch'], ['indirect'])), $.instruction),
       '=',
       alias(seq($._resource_operand, ',', $.integer), $.resource_offset_expression),
       $._newline
@@ -976,7 +1002,10 @@ export default grammar({
       repeat($.resource_modifier)
     ),
 
-    resource_modifier: _ => /(copy(?:_desc(?:ription)?)?|ref(?:erence)?|raw|stereo|mono|stereo2mono|set_viewport|no_view_cache|resolve_msaa|unless_null)/i,
+    resource_modifier: _ => choice(
+      /(copy(?:_desc(?:ription)?)?|ref(?:erence)?|raw|mono|stereo2mono|set_viewport|no_view_cache|resolve_msaa|unless_null)/i,
+      keywords('stereo')
+    ),
 
     _resource_operand: $ => choice(
       $._language_variable,
@@ -1133,14 +1162,18 @@ export default grammar({
 
     scissor_rectangle: _ => /(scissor\d+_(?:left|top|right|bottom))/i,
 
-    override_parameter: _ => new RustRegex(`(?xi)(
-      (?:rt|res|window)_(?:width|height) | (?:vertex|index|instance)_count | first_(?:vertex|index|instance) |
-      thread_group_count_[xyz] | indirect_offset | draw_type | cursor_(?: showing | (?:screen_|window_|hotspot_)?[xy] ) |
-      time | hunting | sli | frame_analysis | effective_dpi | (?:raw_|eye_)?separation | convergence |
-      stereo_(?:active|available) | scissor_(?:left|top|right|bottom) )`
+    // the words that are also instructions or section names are keywords, so they share one token
+    override_parameter: _ => choice(
+      new RustRegex(`(?xi)(
+        (?:rt|res|window)_(?:width|height) | (?:vertex|index|instance)_count | first_(?:vertex|index|instance) |
+        thread_group_count_[xyz] | indirect_offset | draw_type | cursor_(?: showing | (?:screen_|window_|hotspot_)?[xy] ) |
+        time | sli | frame_analysis | effective_dpi | (?:raw|eye)_separation |
+        stereo_(?:active|available) | scissor_(?:left|top|right|bottom) )`
+      ),
+      keywords('hunting', 'separation', 'convergence')
     ),
 
-    static_override_parameter: _ => /(sli|hunting|frame_analysis|stereo_(?:active|available))/i,
+    static_override_parameter: _ => choice(/(sli|frame_analysis|stereo_(?:active|available))/i, keywords('hunting')),
     
     _callable_section: $ => choice(
       $.callable_commandlist,
@@ -1197,12 +1230,12 @@ export default grammar({
       alias(file_regex, $.file_key_value)
     ),
 
-    frame_analysis_option: _ => new RustRegex(`(?xi)(
-      hold|stereo|mono|
+    frame_analysis_option: _ => choice(keywords('stereo'), new RustRegex(`(?xi)(
+      hold|mono|
       dump_(?:rt|depth|tex|[cvi]b)|jp(?:s|e?g)|(?:jp(?:s|e?g)_)?dds|buf|txt|desc|clear_rt|persist|
       filename_(?:reg|handle)|log|dump_on_(?:unmap|update)|deferred_ctx_(?:immediate|accurate)|
       share_dupes|symlink|dump_(?:rt|depth|tex)_(?:jps|dds)|dump_[cvi]b_txt)`
-    ),
+    )),
 
     marking_actions_option: _ => /(clipboard|hlsl|asm|regex|mono_snapshot|stereo_snapshot|snapshot_if_pink)/i,
 
@@ -1237,15 +1270,12 @@ export default grammar({
 
     // based on tree-sitter-zig github PR#10
     doc_comment: $ => prec(3, seq(
-      field('start', ";;!"),
+      field('start', token(prec(2, ";;!"))), // wins over the comment token, which would match a longer run
       field('content', $.doc_comment_content)
     )),
 
-    comment: $ => prec(1, seq(
-      field('start', ';'),
-      field('content', /[^\r\n]*/),
-      $._newline
-    )),
+    // a single leaf so comment lines cost one node and no scanner call; the content starts one byte after the node
+    comment: _ => token(prec(1, /;[^\r\n]*/)),
 
     null: _ => /null/i,
 
@@ -1270,5 +1300,10 @@ export default grammar({
     _post: _ => /post/i,
 
     _significant_ws: _ => /[ \t]+/i,
+
+    // a line ending lexed without the external scanner, for lines that can never be the last one in a valid file,
+    // unlike $._newline which also has to accept the end of input. It matches the same text as the `\r?\n` extra;
+    // like $._significant_ws, it is lexed as this token where it is valid and skipped as an extra everywhere else
+    _line_break: _ => /\r?\n/,
   }
 });
@@ -1,180 +1,250 @@
 #include "tree_sitter/parser.h"
-#include "tree_sitter/alloc.h"
-#include "tree_sitter/array.h"
+#include "scanner_tokens.h"
 
-#include <ctype.h>
-#include <wctype.h>
 #include <string.h>
+#include <wctype.h>
 
-#define strlwr _tolower_str
 #define scan_section_header_prefix scan_maybe_section_header
 
-typedef enum {
-    EXTERNAL_LINE,
-    SECTION_HEADER_START,
-    SECTION_HEADER_GUARD,
-    KEY_HEADER_PREFIX,
-    REGEX_HEADER_PREFIX,
-    PRESET_HEADER_PREFIX,
-    INCLUDE_HEADER_PREFIX,
-    COMMANDLIST_HEADER_PREFIX,
-    COMMANDLIST_CALLABLE_PREFIX,
-    CUSTOMSHADER_CALLABLE_PREFIX,
-    CUSTOMRESOURCE_HEADER_PREFIX,
-    NAMESPACE_RESOLUTION_START,
-    NAMESPACE_RESOLUTION_CONTENT,
-    NAMESPACE_RESOLUTION_END,
-    SUFFIXED_KEY_HEADER,
-    SUFFIXED_PRESET_HEADER,
-    // Resource[^\]]+
-    SUFFIXED_RESOURCE_HEADER,
-    // Include[^\]]*
-    SUFFIXED_INCLUDE_HEADER,
-    // (?:ShaderOverride|TextureOverride|(?:BuiltIn)?(?:CommandList|CustomShader))[^\]]+
-    SUFFIXED_COMMANDLIST_HEADER,
-    REGEX_COMMANDLIST_HEADER,
-    REGEX_DECLARATIONS_HEADER,
-    REGEX_PATTERN_HEADER,
-    REGEX_REPLACE_HEADER,
-    NEWLINE,
-    DOC_COMMENT_CONTENT,
-    ERROR_SENTINEL,
-} TokenType;
-
-const char *SECTION_PREFIX_NAMES[] = {
-    "shaderoverride",
-    "shaderregex",
-    "customshader", // + builtincustomshader
-    "commandlist",  // + builtincommandlist
-    "textureoverride",
-    "resource",
-    "include",
-    "preset",
-    "key",
-    0
-};
-
-// Intentionally leaves out a few names with unique first letters
-const char *SECTION_NAMES[] = {
-    "shaderoverride",
-    "shaderregex",
-    "customshader",
-    "commandlist",
-    "builtincustomshader",
-    "builtincommandlist",
-    "present",
-    "clearrendertargetview",
-    "cleardepthstencilview",
-    "clearunorderedaccessviewuint",
-    "clearunorderedaccessviewfloat",
-    "constants",
-    "logging",
-    "system",
-    "stereo",
-    "rendering",
-    "profile",
-    "convergencemap",
-    "resource",
-    "preset",
-    "loader",
-    0
-};
+#ifdef TREE_SITTER_MIGOTO_SCANNER_STATS
+#include "tree_sitter/tree-sitter-migoto.h"
 
-typedef enum {
-    NOTSEARCHING,
-    GENSEARCH = 4,
-    INSSEARCH,
-    PATSEARCH,
-    REPSEARCH,
-} SearchState;
+// Process-wide and unsynchronized: meant for profiling a corpus from a single thread
+static TSMigotoScannerStats scanner_stats[ERROR_SENTINEL + 1];
 
-typedef Array(char) String;
+// The token the current scan is searching for, which its work is attributed to
+static TokenType stats_token;
 
-typedef struct {
-    String word;
-} Scanner;
-
-static inline void reset(Scanner *scanner) {
-    array_delete(&scanner->word);
-    array_init(&scanner->word);
+/// Attributes the current scan to the first valid token in [first, last]
+static inline void stats_search(const bool *valid_symbols, TokenType first, TokenType last) {
+    stats_token = first;
+    for (int t = first; t <= (int)last; t++) {
+        if (valid_symbols[t]) {
+            stats_token = (TokenType)t;
+            return;
+        }
+    }
 }
 
+#define STATS_SEARCH(first, last) stats_search(valid_symbols, (first), (last))
+#define STATS_COUNT(field) (scanner_stats[stats_token].field++)
+#else
+#define STATS_SEARCH(first, last)
+#define STATS_COUNT(field)
+#endif
+
+// Every token is decided from the text ahead of it alone, so the scanner keeps no state between calls
+// and serializes to nothing, which lets tree-sitter skip storing and comparing external scanner state.
+// There is no payload either: creating, restoring and destroying a scanner never touch the heap,
+// so a parser per file costs nothing here however many small files are parsed.
+//
+// The one exception is error recovery, where the indentation of a line is taken as a token of its own and the scan
+// right after it has to know that it is at the first token of the line. Only that token serializes its end column,
+// so valid files still serialize to nothing. tree-sitter restores the state, scans and serializes on one thread
+// without anything in between, so the column is kept in a thread-local instead of a payload.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+#define NO_COLUMN UINT32_MAX
+
+/// The column the last token ended at, if it was the indentation of a line during error recovery
+static THREAD_LOCAL uint32_t indented_column = NO_COLUMN;
+
 void *tree_sitter_migoto_external_scanner_create() {
-    Scanner *scanner = ts_calloc(1, sizeof(Scanner));
-    array_reserve(&scanner->word, 256);
-    return scanner;
+    return NULL;
 }
 
 void tree_sitter_migoto_external_scanner_destroy(void *payload) {
-    Scanner *scanner = (Scanner*) payload;
-    array_delete(&scanner->word);
-    ts_free(scanner);
+    (void)payload;
 }
 
 unsigned tree_sitter_migoto_external_scanner_serialize(void *payload, char *buffer) {
-    unsigned size = 0;
-    Scanner *scanner = (Scanner*) payload;
-
-    if (scanner->word.size * sizeof(char) + 1 >= TREE_SITTER_SERIALIZATION_BUFFER_SIZE) {
+    (void)payload;
+    if (indented_column == NO_COLUMN) {
         return 0;
     }
 
-    buffer[size++] = (char) scanner->word.size;
-    memcpy(&buffer[size], scanner->word.contents, scanner->word.size);
-    size += scanner->word.size;
-    return size;
+    memcpy(buffer, &indented_column, sizeof(indented_column));
+    return sizeof(indented_column);
 }
 
 void tree_sitter_migoto_external_scanner_deserialize(void *payload, const char *buffer, unsigned length) {
-    unsigned size = 0;
-    Scanner *scanner = (Scanner*) payload;
+    (void)payload;
+    indented_column = NO_COLUMN;
+    if (length == sizeof(indented_column)) {
+        memcpy(&indented_column, buffer, sizeof(indented_column));
+    }
+}
+
+static inline void consume(TSLexer *lexer) { STATS_COUNT(characters); lexer->advance(lexer, false); }
+
+static inline void skip(TSLexer *lexer) { STATS_COUNT(characters); lexer->advance(lexer, true); }
+
+// tree-sitter reports a lookahead of 0 at the end of input, so the indirect eof call is only needed then
+static inline bool is_eof(TSLexer *lexer) { return lexer->lookahead == 0 && lexer->eof(lexer); }
+
+static inline void mark_end(TSLexer *lexer) { lexer->mark_end(lexer); }
+
+/// The most characters a header or namespace scan reads before giving up on the token.
+/// Those scans can fail after reading to the end of a line, so without a bound a single huge line would make the
+/// scans at each of its positions quadratic. With it every scanner call reads O(SCAN_LIMIT) characters beyond the token
+/// it returns, so a parse costs at most SCAN_LIMIT character reads per input byte no matter how the input is broken.
+/// No real header or namespace path comes anywhere near this length.
+#define SCAN_LIMIT 4096
+
+enum {
+    CHAR_SPACE = 1 << 0,         // iswspace
+    CHAR_NAME_END = 1 << 1,      // ends a section name: ] \n
+    CHAR_SUFFIX_END = 1 << 2,    // ends a header suffix: ] \r \n
+    CHAR_SECTION_START = 1 << 3, // can start a section name: s t c b p l r h k i
+    CHAR_UPPER = 1 << 4,         // folds to lowercase by setting 0x20
+    CHAR_NAMESPACE_END = 1 << 5, // ends a namespace path: operators, $ ? : , and line endings
+};
+
+#define SECTION_START_PAIR(lower) [lower] = CHAR_SECTION_START, [lower - 0x20] = CHAR_SECTION_START | CHAR_UPPER
+
+/// Classes of the ASCII characters, which make up nearly all of any ini file.
+/// Anything outside of ASCII takes the slower locale-aware path in the helpers below.
+static const uint8_t CHAR_CLASSES[128] = {
+    ['\t'] = CHAR_SPACE,
+    ['\n'] = CHAR_SPACE | CHAR_NAME_END | CHAR_SUFFIX_END | CHAR_NAMESPACE_END,
+    ['\v'] = CHAR_SPACE,
+    ['\f'] = CHAR_SPACE,
+    ['\r'] = CHAR_SPACE | CHAR_SUFFIX_END | CHAR_NAMESPACE_END,
+    [' '] = CHAR_SPACE,
+    [']'] = CHAR_NAME_END | CHAR_SUFFIX_END,
+    ['='] = CHAR_NAMESPACE_END, ['&'] = CHAR_NAMESPACE_END, ['|'] = CHAR_NAMESPACE_END, ['+'] = CHAR_NAMESPACE_END,
+    ['-'] = CHAR_NAMESPACE_END, ['/'] = CHAR_NAMESPACE_END, ['*'] = CHAR_NAMESPACE_END, ['<'] = CHAR_NAMESPACE_END,
+    ['>'] = CHAR_NAMESPACE_END, ['%'] = CHAR_NAMESPACE_END, ['!'] = CHAR_NAMESPACE_END, ['$'] = CHAR_NAMESPACE_END,
+    ['?'] = CHAR_NAMESPACE_END, [':'] = CHAR_NAMESPACE_END, [','] = CHAR_NAMESPACE_END,
+    ['A'] = CHAR_UPPER, ['D'] = CHAR_UPPER, ['E'] = CHAR_UPPER, ['F'] = CHAR_UPPER, ['G'] = CHAR_UPPER,
+    ['J'] = CHAR_UPPER, ['M'] = CHAR_UPPER, ['N'] = CHAR_UPPER, ['O'] = CHAR_UPPER, ['Q'] = CHAR_UPPER,
+    ['U'] = CHAR_UPPER, ['V'] = CHAR_UPPER, ['W'] = CHAR_UPPER, ['X'] = CHAR_UPPER, ['Y'] = CHAR_UPPER,
+    ['Z'] = CHAR_UPPER,
+    SECTION_START_PAIR('s'), SECTION_START_PAIR('t'), SECTION_START_PAIR('c'), SECTION_START_PAIR('b'),
+    SECTION_START_PAIR('p'), SECTION_START_PAIR('l'), SECTION_START_PAIR('r'), SECTION_START_PAIR('h'),
+    SECTION_START_PAIR('k'), SECTION_START_PAIR('i'),
+};
 
-    reset(scanner);
+#undef SECTION_START_PAIR
 
-    if (length == 0) return;
+static inline bool is_ascii(int32_t c) { return (uint32_t)c < 0x80; }
 
-    scanner->word = (String)array_new();
-    uint8_t word_length = buffer[size++];
-    array_reserve(&scanner->word, word_length);
-    memcpy(scanner->word.contents, &buffer[size], word_length);
-    scanner->word.size = word_length;
-    size += word_length;
-    
-    assert(size == length);
+static inline uint8_t char_class(int32_t c) { return is_ascii(c) ? CHAR_CLASSES[c] : 0; }
+
+static inline bool is_space(int32_t c) { return is_ascii(c) ? (CHAR_CLASSES[c] & CHAR_SPACE) : iswspace(c); }
+
+static inline int32_t to_lower(int32_t c) {
+    if (is_ascii(c)) {
+        return (CHAR_CLASSES[c] & CHAR_UPPER) ? (c | 0x20) : c;
+    }
+    return (int32_t)towlower(c);
 }
 
-static inline void consume(TSLexer *lexer) { lexer->advance(lexer, false); }
+typedef struct {
+    const char *name;   // lowercase
+    uint8_t length;     // characters of name that must match for a word to be accepted
+    bool exact;         // the word must also end right after those characters
+} SectionName;
+
+#define NAME(name, length) {(name), (length), false}
+#define EXACT_NAME(name, length) {(name), (length), true}
+
+// Names are accepted at the shortest length searched for their first letter, which is why several are cut short
+static const SectionName S_NAMES[] = {NAME("shader", 6), NAME("system", 6), NAME("stereo", 6)};
+static const SectionName C_NAMES[] = {
+    NAME("customshade", 11), NAME("commandlist", 11), NAME("convergence", 11),
+    NAME("clearrender", 11), NAME("cleardepths", 11), NAME("clearunorde", 11),
+    EXACT_NAME("constants", 9),
+};
+static const SectionName B_NAMES[] = {NAME("builtincustomshade", 18), NAME("builtincommandlist", 18)};
+static const SectionName P_NAMES[] = {NAME("presen", 6), NAME("preset", 6), NAME("profil", 6)};
+static const SectionName L_NAMES[] = {NAME("loggin", 6), NAME("loader", 6)};
+static const SectionName R_NAMES[] = {NAME("renderin", 8), NAME("resource", 8)};
+// "customshader" is listed before "customshade" so its index can be checked for the longer match
+static const SectionName C_PREFIX_NAMES[] = {NAME("customshader", 12), NAME("customshade", 11), NAME("commandlist", 11)};
+
+static const SectionName TEXTUREOVERRIDE = NAME("textureoverride", 15);
+static const SectionName SHADERREGEX = NAME("shaderregex", 11);
+static const SectionName SHADEROVERRIDE = NAME("shaderoverride", 14);
+static const SectionName CUSTOMSHADER = NAME("customshader", 12);
+static const SectionName COMMANDLIST = NAME("commandlist", 11);
+static const SectionName PRESET = NAME("preset", 6);
+static const SectionName DEVICE = NAME("device", 6);
+static const SectionName RESOURCE = NAME("resource", 8);
+static const SectionName HUNTING = NAME("hunting", 7);
+static const SectionName KEY = NAME("key", 3);
+static const SectionName INCLUDE = NAME("include", 7);
+
+#undef NAME
+#undef EXACT_NAME
+
+/// A case-insensitive trie over a handful of names, flattened into a bitmask of the names that still agree with the input.
+/// Characters are matched as they are consumed, so nothing is buffered or lowercased afterwards.
+typedef struct {
+    const SectionName *names;
+    uint32_t count;
+    uint32_t live;
+    uint32_t length; // characters fed so far
+} NameMatcher;
 
-static inline void skip(TSLexer *lexer) { lexer->advance(lexer, true); }
+#define matcher_new(names, count, length) ((NameMatcher){(names), (count), (1u << (count)) - 1, (length)})
+#define matcher_for(names) matcher_new((names), sizeof(names) / sizeof((names)[0]), 0)
 
-static inline bool is_eof(TSLexer *lexer) { return lexer->eof(lexer); }
+static inline void matcher_feed(NameMatcher *matcher, int32_t character) {
+    // only ASCII letters occur in names, so folding the 0x20 bit cannot alias any other character
+    int32_t folded = character | 0x20;
 
-static inline void mark_end(TSLexer *lexer) { lexer->mark_end(lexer); }
+    for (uint32_t i = 0; i < matcher->count && matcher->live; i++) {
+        const SectionName *name = &matcher->names[i];
+        if (matcher->length < name->length && folded != name->name[matcher->length]) {
+            matcher->live &= ~(1u << i);
+        }
+    }
+
+    matcher->length++;
+}
 
-/// Lowercase a string in place
-static inline char *_tolower_str(char *_Str) {
-    size_t i = 0;
+static inline bool matcher_accepts_name(const NameMatcher *matcher, uint32_t i) {
+    const SectionName *name = &matcher->names[i];
+    return (matcher->live & (1u << i)) &&
+        (name->exact ? matcher->length == name->length : matcher->length >= name->length);
+}
 
-    while (_Str[i] != '\0') {
-        _Str[i] = (char) towlower(_Str[i]);
-        i++;
+static inline bool matcher_accepts(const NameMatcher *matcher) {
+    for (uint32_t i = 0; i < matcher->count; i++) {
+        if (matcher_accepts_name(matcher, i)) return true;
     }
+    return false;
+}
 
-    return _Str;
+/// Consumes the characters of a lowercase name, stopping at the first that does not match
+static inline bool consume_name(TSLexer *lexer, const char *name, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        if ((lexer->lookahead | 0x20) != name[i]) return false;
+        consume(lexer);
+    }
+    return true;
 }
 
-/// Determines if search_term exactly matches one of the section names in search_arr, using multiple sizes to test multiple options
-/// @returns An integer representing the 1-indexed position in the sizes array of a match, and 0 otherwise.
-static inline int is_section_name_l(char *search_term, uint8_t *sizes, const char **search_arr) {
-    strlwr(search_term); // mutates search_term
-    for(int i = 0; search_arr[i]; i++) {
-        for (int j = 0; sizes[j]; j++) {
-            if(!strncmp(search_term, search_arr[i], sizes[j])) {
-                return j+1;
-            }
+/// Consumes the rest of the line up to its newline, with no work per character beyond the newline test.
+/// Stopping before the newline keeps the token from reading the first character of the next line.
+static inline void consume_line(TSLexer *lexer) {
+    for (;;) {
+        int32_t lookahead = lexer->lookahead;
+        if (lookahead == '\n') {
+            return;
         }
+        // tree-sitter reports a lookahead of 0 at the end of input, so only that needs the eof check
+        if (lookahead == 0 && lexer->eof(lexer)) {
+            return;
+        }
+        consume(lexer);
     }
-    return 0;
 }
 
 static inline bool scan_end_of_line(TSLexer *lexer) {
@@ -186,11 +256,12 @@ static inline bool scan_end_of_line(TSLexer *lexer) {
         // fprintf(stderr, "[Lykare]: starting loop iteration\n");
         if (lexer->lookahead == '\n') {
             // fprintf(stderr, "[Lykare]: found newline\n");
+            // the token is zero-width, so the newline is left to extras rather than skipped here,
+            // which would read the first character of the next line
             found_end_of_line = true;
-            skip(lexer);
             break;
         }
-        else if (iswspace(lexer->lookahead) && lexer->lookahead != '\n') {
+        else if (is_space(lexer->lookahead) && lexer->lookahead != '\n') {
             // fprintf(stderr, "[Lykare]: found non-newline whitespace\n");
             skip(lexer);
         }
@@ -225,47 +296,38 @@ static inline bool scan_namespace_res_start_end(TSLexer *lexer, unsigned positio
     return true;
 }
 
+/// Scans the path between the backslashes of `$\path\to\namespace\variable`, ending the token at the last backslash.
+/// The scan stops at the first character that cannot be part of a namespace path, such as the operator, comma or line
+/// ending after the variable or the `$` of the next one, so a whole line of namespaced references is read only once
+/// and a list like `run = CommandList\a\A, CommandList\b\B` never takes the next reference into the namespace.
 static inline bool scan_namespace_res_content(TSLexer *lexer) {
-    for (;;) {
-        if (is_eof(lexer)) {
-            return false;
-        }
+    bool saw_separator = false;
+    uint32_t scanned = 0;
 
-        switch (lexer->lookahead) {
-        case '$':
-            consume(lexer);
-            if (lexer->lookahead != '\\')
-                continue;
-            else
-                return false;
-            break;
-        case '\\':
+    for (; scanned < SCAN_LIMIT && !is_eof(lexer); scanned++) {
+        if (lexer->lookahead == '\\') {
             mark_end(lexer);
-            consume(lexer);
-            break;
-        case '=':
-        case '&':
-        case '|':
-        case '+':
-        case '-':
-        case '/':
-        case '*':
-        case '<':
-        case '>':
-        case '%':
-        case '!':
-        case '\n':
-            lexer->result_symbol = NAMESPACE_RESOLUTION_CONTENT;
-            consume(lexer);
-            return true;        
-        default:
-            consume(lexer);
+            saw_separator = true;
+        }
+        else if (char_class(lexer->lookahead) & CHAR_NAMESPACE_END) {
             break;
         }
+
+        consume(lexer);
+    }
+
+    // the namespace has to be closed by a backslash before the variable name
+    if (!saw_separator || scanned == SCAN_LIMIT) {
+        return false;
     }
+
+    lexer->result_symbol = NAMESPACE_RESOLUTION_CONTENT;
+    return true;
 }
 
-static inline bool scan_maybe_section_header(Scanner *scanner, TSLexer *lexer, const bool *valid_symbols, bool is_prefix_search) {
+static inline bool scan_maybe_section_header(TSLexer *lexer, const bool *valid_symbols, bool is_prefix_search) {
+    STATS_COUNT(section_header_searches);
+
     if (!is_prefix_search) {
         consume(lexer); // consume the '[' that starts
     }
@@ -276,7 +338,9 @@ static inline bool scan_maybe_section_header(Scanner *scanner, TSLexer *lexer, c
     }
 
     // consume all the leading whitespace
-    while (iswspace(lexer->lookahead) && !is_eof(lexer)) {
+    for (uint32_t scanned = 0; is_space(lexer->lookahead) && !is_eof(lexer); scanned++) {
+        if (scanned == SCAN_LIMIT) return false;
+
         // if it's a prefix search we should skip the leading whitespace and not include it in the final token
         if (is_prefix_search && (
             valid_symbols[COMMANDLIST_CALLABLE_PREFIX] ||
@@ -293,27 +357,25 @@ static inline bool scan_maybe_section_header(Scanner *scanner, TSLexer *lexer, c
     }
 
     // if after consuming whitespace we're at a terminal or eof, return false
-    if (lexer->lookahead == ']' || lexer->lookahead == '\n' || is_eof(lexer)) {
+    if ((char_class(lexer->lookahead) & CHAR_NAME_END) || is_eof(lexer)) {
         return false;
     }
 
     // if the next character is not alphabetical, return false
     // if it is alphabetical, but not the first character of a section name, return false
     // otherwise we can start searching
-    // would love to just use strchr here, but wasm with wasi-sdk doesn't have support for it
-    if (!iswalpha(lexer->lookahead) ||
-        memchr("stcbplrhki", towlower(lexer->lookahead), 11) == NULL)
-    {
+    if (!(char_class(lexer->lookahead) & CHAR_SECTION_START)) {
         return false;
     }
 
-    uint8_t search_lengths[7] = {0, 0, 0, 0, 0, 0, 0};
-    char *target_term = 0;
+    NameMatcher matcher = {0};
+    uint8_t search_length = 0;
+    bool is_split_prefix = false; // the COMMANDLIST_HEADER_PREFIX 'c' situation, where the token may end after either name
 
-    // choose the search length or set target term based on first character
+    // choose the names to match and how many characters to search based on the first character
     // s [6,11,14], c [11,12,14,21,28,29], b [18,19], p [6,7], l [6,7], r [8,9]: all have multiple options for header
 callable:
-    switch (towlower(lexer->lookahead)) {
+    switch (to_lower(lexer->lookahead)) {
     case 's':
         if (is_prefix_search) {
             // If we see 's' and it's a prefix search, it could be "ShaderRegex" or "ShaderOverride"
@@ -321,28 +383,19 @@ callable:
                 valid_symbols[COMMANDLIST_HEADER_PREFIX])
             {
                 // we need to perform lookahead to the difference in possibilities
-                // and be sure to collect what we consume in the scanner word
-                for (int i = 0; i < 6; i++) {
-                    array_push(&scanner->word, lexer->lookahead);
-                    consume(lexer);
+                if (!consume_name(lexer, "shader", 6)) {
+                    return false;
                 }
-                array_push(&scanner->word, '\0'); // NUL term char array before comparison
 
-                if (!strcmp(strlwr(scanner->word.contents), "shader")) {
-                    if (towlower(lexer->lookahead) == 'r') {
-                        lexer->result_symbol = REGEX_HEADER_PREFIX;
-                        target_term = "shaderregex";
-                        search_lengths[0] = 11; // ShaderRegex
-                    }
-                    else if (towlower(lexer->lookahead) == 'o') {
-                        lexer->result_symbol = COMMANDLIST_HEADER_PREFIX;
-                        target_term = "shaderoverride";
-                        search_lengths[0] = 14; // ShaderOverride
-                    }
-                    else {
-                        return false;
-                    }
-                    array_pop(&scanner->word); // remove the null terminator before proceeding
+                if (to_lower(lexer->lookahead) == 'r') {
+                    lexer->result_symbol = REGEX_HEADER_PREFIX;
+                    matcher = matcher_new(&SHADERREGEX, 1, 6);
+                    search_length = 11; // ShaderRegex
+                }
+                else if (to_lower(lexer->lookahead) == 'o') {
+                    lexer->result_symbol = COMMANDLIST_HEADER_PREFIX;
+                    matcher = matcher_new(&SHADEROVERRIDE, 1, 6);
+                    search_length = 14; // ShaderOverride
                 }
                 else {
                     return false;
@@ -354,16 +407,15 @@ callable:
         }
         else {
             // it's not a prefix search, just go through the possibilities as normal
-            search_lengths[0] = 14; // ShaderOverride
-            search_lengths[1] = 11; // ShaderRegex
-            search_lengths[2] = 6;  // System
+            matcher = matcher_for(S_NAMES);
+            search_length = 14; // ShaderOverride
         }
         break;
     case 't':
         // only TextureOverride starts with 't' of the prefixed headers
         if (is_prefix_search) lexer->result_symbol = COMMANDLIST_HEADER_PREFIX;
-        target_term = "textureoverride";
-        search_lengths[0] = 15;
+        matcher = matcher_new(&TEXTUREOVERRIDE, 1, 0);
+        search_length = 15;
         break;
     case 'c':
         if (is_prefix_search) {
@@ -372,17 +424,16 @@ callable:
                 valid_symbols[COMMANDLIST_CALLABLE_PREFIX])
             {
                 // If we are looking for the callables, we need to perform an extra lookahead
-                array_push(&scanner->word, lexer->lookahead);
                 consume(lexer); // consume the 'c'
-                if (towlower(lexer->lookahead) == 'u') {
+                if (to_lower(lexer->lookahead) == 'u') {
                     lexer->result_symbol = CUSTOMSHADER_CALLABLE_PREFIX;
-                    target_term = "customshader";
-                    search_lengths[0] = 12; // CustomShader
+                    matcher = matcher_new(&CUSTOMSHADER, 1, 1);
+                    search_length = 12; // CustomShader
                 }
-                else if (towlower(lexer->lookahead) == 'o') {
+                else if (to_lower(lexer->lookahead) == 'o') {
                     lexer->result_symbol = COMMANDLIST_CALLABLE_PREFIX;
-                    target_term = "commandlist";
-                    search_lengths[0] = 11; // CommandList
+                    matcher = matcher_new(&COMMANDLIST, 1, 1);
+                    search_length = 11; // CommandList
                 }
                 else {
                     return false;
@@ -390,34 +441,24 @@ callable:
             }
             else if (valid_symbols[COMMANDLIST_HEADER_PREFIX]) {
                 lexer->result_symbol = COMMANDLIST_HEADER_PREFIX;
-                search_lengths[0] = 12; // CustomShader
-                search_lengths[1] = 11; // CommandList
+                matcher = matcher_for(C_PREFIX_NAMES);
+                search_length = 12; // CustomShader
+                is_split_prefix = true;
             }
             else {
                 return false;
             }
         }
         else {
-            search_lengths[0] = 29; // ClearUnorderedAccessViewFloat
-            search_lengths[1] = 28; // ClearUnorderedAccessViewUint
-            search_lengths[2] = 21; // ClearRenderTargetView / ClearDepthStencilView
-            search_lengths[3] = 14; // ConvergenceMap
-            search_lengths[4] = 12; // CustomShader
-            search_lengths[5] = 11; // CommandList
+            matcher = matcher_for(C_NAMES);
+            search_length = 29; // ClearUnorderedAccessViewFloat
         }
         break;
     case 'b':
         // This is just the 'c' case but we need to confirm and consume the "BuiltIn" part first
         // Only really necessary for a prefix search, prefixed-header search can just proceed as normal
         if (is_prefix_search) {
-            for (int i = 0; i < 7; i++) {
-                array_push(&scanner->word, lexer->lookahead);
-                consume(lexer);
-            }
-            array_push(&scanner->word, '\0'); // NUL term char array before comparison
-
-            if (!strcmp(strlwr(scanner->word.contents), "builtin")) {
-                reset(scanner);
+            if (consume_name(lexer, "builtin", 7)) {
                 goto callable;
             }
             else {
@@ -425,199 +466,154 @@ callable:
             }
         }
         else {
-            search_lengths[0] = 19; // BuiltInCustomShader
-            search_lengths[1] = 18; // BuiltInCommandList
+            matcher = matcher_for(B_NAMES);
+            search_length = 19; // BuiltInCustomShader
         }
         break;
     case 'p':
         if (is_prefix_search) {
             lexer->result_symbol = PRESET_HEADER_PREFIX;
-            target_term = "preset";
-            search_lengths[0] = 6;
+            matcher = matcher_new(&PRESET, 1, 0);
+            search_length = 6;
         }
         else {
-            search_lengths[0] = 7;
-            search_lengths[1] = 6;
+            matcher = matcher_for(P_NAMES);
+            search_length = 7;
         }
         break;
     case 'l':
         // There are no prefixes that start with 'l'
         if (is_prefix_search) return false;
-        search_lengths[0] = 7;
-        search_lengths[1] = 6;
+        matcher = matcher_for(L_NAMES);
+        search_length = 7;
         break;
     case 'd':
         // There are no prefixes that start with 'd'
         if (is_prefix_search) return false;
-        target_term = "device";
-        search_lengths[0] = 6;
+        matcher = matcher_new(&DEVICE, 1, 0);
+        search_length = 6;
         break;
     case 'r':
         if (is_prefix_search) {
             lexer->result_symbol = CUSTOMRESOURCE_HEADER_PREFIX;
-            target_term = "resource";
-            search_lengths[0] = 8;
+            matcher = matcher_new(&RESOURCE, 1, 0);
+            search_length = 8;
         }
         else {
-            search_lengths[0] = 9;
-            search_lengths[1] = 8;
+            matcher = matcher_for(R_NAMES);
+            search_length = 9;
         }
         break;
     case 'h':
         // There are no prefixes that start with 'h'
         if (is_prefix_search) return false;
-        target_term = "hunting";
-        search_lengths[0] = 7;
+        matcher = matcher_new(&HUNTING, 1, 0);
+        search_length = 7;
         break;
     case 'k':
         if (is_prefix_search) lexer->result_symbol = KEY_HEADER_PREFIX;
-        target_term = "key";
-        search_lengths[0] = 3;
+        matcher = matcher_new(&KEY, 1, 0);
+        search_length = 3;
         break;
     case 'i':
         if (is_prefix_search) lexer->result_symbol = INCLUDE_HEADER_PREFIX;
-        target_term = "include";
-        search_lengths[0] = 7;
+        matcher = matcher_new(&INCLUDE, 1, 0);
+        search_length = 7;
         break;
     default:
         return false;
     }
 
-    char lookahead = lexer->lookahead;
-
     do {
+        int32_t lookahead = lexer->lookahead;
+
         // if we see a terminal before collecting the longest number of characters
-        if (lookahead == ']' || lookahead == '\n' || is_eof(lexer)) {
+        if ((char_class(lookahead) & CHAR_NAME_END) || is_eof(lexer)) {
             break;
         }
 
-        array_push(&scanner->word, lookahead);
+        matcher_feed(&matcher, lookahead);
         consume(lexer);
-        // Should only happen with the COMMANDLIST_HEADER_PREFIX 'c' situation
-        if (!target_term && scanner->word.size == search_lengths[1] && is_prefix_search) {
+        // the shorter of the two names ends the token unless the longer one matches
+        if (is_split_prefix && matcher.length == 11) {
             mark_end(lexer);
         }
-        lookahead = lexer->lookahead;
-    } while (scanner->word.size < search_lengths[0]);
+    } while (matcher.length < search_length);
 
-    if (is_prefix_search && target_term) mark_end(lexer);
+    if (is_prefix_search && !is_split_prefix) mark_end(lexer);
 
-    array_push(&scanner->word, '\0'); // NUL term char array before comparison
+    bool is_match = matcher_accepts(&matcher);
 
-    if (target_term && !strcmp(strlwr(scanner->word.contents), target_term)) {
-        reset(scanner);
-        return true;
-    }
-    else if (!target_term) {
-        int match_idx = 0;
-        match_idx =
-            is_section_name_l(
-                scanner->word.contents,
-                search_lengths,
-                is_prefix_search ? SECTION_PREFIX_NAMES : SECTION_NAMES
-            );
-        
-        // if we had the COMMANDLIST_HEADER_PREFIX 'c' situation and the shorter name did not match, but the longer did
-        // be sure to include that 1 extra character in the token
-        if (match_idx && match_idx == 1 && is_prefix_search) {
-            mark_end(lexer);
-        }
-
-        reset(scanner);
-        return match_idx;
+    // if we had the COMMANDLIST_HEADER_PREFIX 'c' situation and the longer name matched
+    // be sure to include that 1 extra character in the token
+    if (is_split_prefix && matcher_accepts_name(&matcher, 0)) {
+        mark_end(lexer);
     }
 
-    reset(scanner);
-    return false;
+    return is_match;
 }
 
-static inline bool scan_section_header_lookahead(Scanner *scanner, TSLexer *lexer, const bool *valid_symbols) {
+/// Decides, once per line boundary, whether the next non-blank line starts a section.
+/// The parse table only ever asks for SECTION_HEADER_START together with SECTION_HEADER_GUARD, so this single verdict
+/// serves both tokens: the guard is returned when a line of text follows, and the start when a section header does.
+/// The blank lines before that line are skipped, so they become the token's padding and the zero-width token sits at
+/// the start of the line it decides on. Nothing past the end of that line is read, so an edit to a later line, even
+/// the header of the next section, leaves the token valid.
+static inline bool scan_section_header_lookahead(TSLexer *lexer, const bool *valid_symbols) {
     // fprintf(stderr, "[Lykare]: lookahead for section header\n");
-    bool saw_text = false;
     bool is_guard = (valid_symbols[SECTION_HEADER_GUARD] && !valid_symbols[SECTION_HEADER_START]);
     bool both_valid = (valid_symbols[SECTION_HEADER_GUARD] && valid_symbols[SECTION_HEADER_START]);
-    
-    // if (both_valid) fprintf(stderr, "[Lykare]: both symbols valid...\n");
 
     // fprintf(stderr, "[Lykare]: eating consecutive newlines if present\n");
     while (lexer->lookahead == '\r' || lexer->lookahead == '\n') {
-        // fprintf(stderr, "[Lykare]: starting loop iteration\n");
         skip(lexer);
     }
 
     for (;;) {
-        // fprintf(stderr, "[Lykare]: starting loop iteration\n");
-        char lookahead = lexer->lookahead;
-        bool is_wspace = iswspace(lookahead);
+        // fprintf(stderr, "[Lykare]: skip all non-newline ws\n");
+        while (lexer->lookahead != '\n' && is_space(lexer->lookahead)) {
+            skip(lexer);
+        }
 
-        if (lookahead == '\n' || is_eof(lexer)) {
+        if (lexer->lookahead == '\n' || is_eof(lexer)) {
             // fprintf(stderr, "[Lykare]: newline or EOF ahead\n");
-            if (!saw_text) {
-                // fprintf(stderr, "[Lykare]: did not see text\n");
-                if (is_guard) {
-                    // fprintf(stderr, "[Lykare]: is guard, return true unless EOF\n");
-                    lexer->result_symbol = SECTION_HEADER_GUARD;
-                    return !is_eof(lexer);
-                }
-
-                if (is_eof(lexer)) {
-                    lexer->result_symbol = SECTION_HEADER_START;
-                    return false;
-                }
-                
-                // fprintf(stderr, "[Lykare]: was looking for start, break loop\n");
-                break;
+            if (is_guard) {
+                lexer->result_symbol = SECTION_HEADER_GUARD;
+                return !is_eof(lexer);
             }
-            else {
-                // unreachable
-                // fprintf(stderr, "[Lykare]: reached unreachable\n");
+
+            if (is_eof(lexer)) {
+                lexer->result_symbol = SECTION_HEADER_START;
                 return false;
             }
+
+            break;
         }
-        else if (!saw_text && lookahead == ';') {
+
+        if (lexer->lookahead == ';') {
             // fprintf(stderr, "[Lykare]: found a comment line\n");
             lexer->result_symbol = SECTION_HEADER_START;
             return false;
         }
-        else if (!saw_text && lookahead == '[') {
-            // fprintf(stderr, "[Lykare]: potential section start ahead\n");
-            mark_end(lexer);
-
-            if (scan_maybe_section_header(scanner, lexer, valid_symbols, false)) {
-                // fprintf(stderr, "[Lykare]: found section start\n");
-                if (is_guard) {
-                    // fprintf(stderr, "[Lykare]: is guard, so return false\n");
-                    lexer->result_symbol = SECTION_HEADER_GUARD;
-                    return false;
-                }
 
-                // fprintf(stderr, "[Lykare]: was looking for start, so return true\n");
-                lexer->result_symbol = SECTION_HEADER_START;
-                return true;
-            }
+        if (lexer->lookahead != '[') {
+            // fprintf(stderr, "[Lykare]: saw text that wasn't [ or ;\n");
+            break;
         }
-        else {
-            if (!is_wspace && !saw_text) {
-                saw_text = true;
-            }
 
-            if (saw_text && is_guard) {
-                // fprintf(stderr, "[Lykare]: saw text that wasn't [ or ; during guard search, return true\n");
-                lexer->result_symbol = SECTION_HEADER_GUARD;
-                return true;
-            }
-            else if (saw_text) {
-                // fprintf(stderr, "[Lykare]: saw text that wasn't [ or ; during start search\n");
-                break;
-            }
-            else {
-                // fprintf(stderr, "[Lykare]: skip all non-newline ws\n");
-                skip(lexer);
-            }
+        // fprintf(stderr, "[Lykare]: potential section start ahead\n");
+        mark_end(lexer);
+
+        if (scan_maybe_section_header(lexer, valid_symbols, false)) {
+            // a guard fails on a section header, a start succeeds
+            lexer->result_symbol = is_guard ? SECTION_HEADER_GUARD : SECTION_HEADER_START;
+            return !is_guard;
         }
+
+        // not a section header, so keep looking from where the name search stopped
     }
 
-    if (both_valid) {
+    if (is_guard || both_valid) {
         lexer->result_symbol = SECTION_HEADER_GUARD;
         return true;
     }
@@ -627,77 +623,99 @@ static inline bool scan_section_header_lookahead(Scanner *scanner, TSLexer *lexe
     }
 }
 
-static inline bool scan_line(Scanner *scanner, TSLexer *lexer, const bool *valid_symbols) {
+static inline bool scan_line(TSLexer *lexer, const bool *valid_symbols) {
     // fprintf(stderr, "[Lykare]: lookahead for external line\n");
-    bool saw_text = false;
+    lexer->result_symbol = EXTERNAL_LINE;
 
     // fprintf(stderr, "[Lykare]: eating consecutive newlines if present\n");
     while (lexer->lookahead == '\r' || lexer->lookahead == '\n') {
-        // fprintf(stderr, "[Lykare]: starting loop iteration\n");
         skip(lexer);
     }
 
+    // fprintf(stderr, "[Lykare]: skip non-newline/EOF ws\n");
+    while (lexer->lookahead != '\n' && is_space(lexer->lookahead)) {
+        skip(lexer);
+    }
+
+    // an empty line or a comment is not an external line
+    if (lexer->lookahead == '\n' || lexer->lookahead == ';' || is_eof(lexer)) {
+        return false;
+    }
+
+    // fprintf(stderr, "[Lykare]: see [ ahead, if section header, return false\n");
+    if (lexer->lookahead == '[' && scan_maybe_section_header(lexer, valid_symbols, false)) {
+        return false;
+    }
+
+    // Raw-line mode: the line is known not to start a section header and nothing else can end it early,
+    // so consume up to the newline without classifying anything. The newline is left to extras
+    consume_line(lexer);
+    mark_end(lexer);
+    return true;
+}
+
+/// Consumes blank lines and the indentation of the line after them, returning the column it stops at
+static inline uint32_t consume_indentation(TSLexer *lexer) {
+    uint32_t column = 0;
     for (;;) {
-        // fprintf(stderr, "[Lykare]: starting loop iteration\n");
-        char lookahead = lexer->lookahead;
-        bool is_wspace = iswspace(lookahead);
-
-        if (lookahead == '\n' || is_eof(lexer)) {
-            // fprintf(stderr, "[Lykare]: saw newline or EOF\n");
-            if (saw_text) {
-                // fprintf(stderr, "[Lykare]: saw text before, so eat the newline, mark end, return true\n");
-                if (!is_eof(lexer)) consume(lexer);
-                mark_end(lexer);
-                lexer->result_symbol = EXTERNAL_LINE;
-                return true;
-            }
-            else {
-                // fprintf(stderr, "[Lykare]: didn't see text, return false for external line\n");
-                lexer->result_symbol = EXTERNAL_LINE;
-                return false;
-            }
+        if (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
+            column++;
         }
-        else if (!saw_text && lookahead == ';') {
-            // fprintf(stderr, "[Lykare]: did not see text yet, ; ahead, must be comment so return false\n");
-            lexer->result_symbol = EXTERNAL_LINE;
-            return false;
+        else if (lexer->lookahead == '\r' || lexer->lookahead == '\n') {
+            column = 0;
         }
-        else if (!saw_text && lookahead == '[') {
-            // fprintf(stderr, "[Lykare]: did not see text yet, see [ ahead, if section header, return false\n");
-            if (scan_maybe_section_header(scanner, lexer, valid_symbols, false)) {
-                lexer->result_symbol = EXTERNAL_LINE;
-                return false;
-            }
+        else {
+            return column;
+        }
+        consume(lexer);
+    }
+}
 
-            // fprintf(stderr, "[Lykare]: was not a section header ahead, set saw text to true\n");
-            saw_text = true;
+/// Only asked for during error recovery, where every external token is valid: takes the rest of an unparseable line
+/// as one error_sentinel token. No parse state accepts that token, so the parser skips it whole into the error,
+/// instead of lexing and skipping the line one word or character at a time. The line ending, any blank lines
+/// and the indentation of the next line are included so the next scan starts at the first token of a line.
+static inline bool scan_malformed_line(TSLexer *lexer, uint32_t resume_column) {
+    // Recovery can only resume at the first token of a line, which is left to the lexer. The lexer would take the
+    // indentation as a token of its own in the error state, so this scanner takes it instead and remembers where
+    // it ended: the scan at that column is at the first token of a line, any other one is partway into a line
+    uint32_t column = lexer->get_column(lexer);
+    if (column == resume_column) {
+        return false;
+    }
+
+    if (column == 0) {
+        // an unindented line starts right here
+        int32_t c = lexer->lookahead;
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            return false;
         }
-        else {
-            if (!is_wspace && !saw_text) {
-                saw_text = true;
-            }
-            
-            if (saw_text) {
-                // fprintf(stderr, "[Lykare]: saw text, so consume all chars include non-newline/EOF ws\n");
-                consume(lexer);
-            }
-            else {
-                // fprintf(stderr, "[Lykare]: skip non-newline/EOF ws\n");
-                skip(lexer);
-            }
+    }
+    else {
+        while (lexer->lookahead == ' ' || lexer->lookahead == '\t') {
+            skip(lexer);
         }
+
+        // a section header is always a place to resume at
+        if (lexer->lookahead == '[' || is_eof(lexer)) {
+            return false;
+        }
+
+        consume_line(lexer);
     }
 
-    // shouldn't get here but just in case
-    // fprintf(stderr, "[Lykare]: should be unreachable\n");
-    lexer->result_symbol = EXTERNAL_LINE;
-    return false;
+    indented_column = consume_indentation(lexer);
+    mark_end(lexer);
+    lexer->result_symbol = ERROR_SENTINEL;
+    return true;
 }
 
 static inline bool scan_suffixed_section_header(TSLexer *lexer, TokenType current_symbol , const bool *valid_symbols) {
     bool saw_text = false, on_ws = true, is_start = true, not_error = (current_symbol != ERROR_SENTINEL);
-    for (;;) {
-        if (lexer->lookahead == ']' || lexer->lookahead == '\r' || lexer->lookahead == '\n' || is_eof(lexer)) {
+    for (uint32_t scanned = 0;; scanned++) {
+        if (scanned == SCAN_LIMIT) return false;
+
+        if ((char_class(lexer->lookahead) & CHAR_SUFFIX_END) || is_eof(lexer)) {
             if (not_error) lexer->result_symbol = current_symbol;
 
             // if we see a terminal but have not seen any text yet
@@ -710,7 +728,7 @@ static inline bool scan_suffixed_section_header(TSLexer *lexer, TokenType curren
 
             return not_error; // return captured text excluding the trailing whitespace
         }
-        else if (iswspace(lexer->lookahead)) {
+        else if (is_space(lexer->lookahead)) {
             if (is_start) is_start = false;
             if (!on_ws) {
                 on_ws = true;
@@ -738,230 +756,238 @@ static inline bool scan_suffixed_section_header(TSLexer *lexer, TokenType curren
     }
 }
 
-static inline bool scan_for_regex_suffix(Scanner *scanner, TSLexer *lexer, const bool *valid_symbols) {
-    SearchState ss = NOTSEARCHING;
-    TokenType result;
-    char *search_target;
+/// Recognizes the `.Pattern`, `.Pattern.Replace` and `.InsertDeclarations` suffixes of a ShaderRegex name in one
+/// forward pass. The state is the token the dotted segment being read would complete, and the characters of that
+/// segment still expected, so each character costs one comparison and nothing is buffered.
+static inline bool scan_for_regex_suffix(TSLexer *lexer, const bool *valid_symbols) {
+    TokenType segment = REGEX_COMMANDLIST_HEADER; // no suffix segment is being matched
+    const char *expected = "";
+    bool after_dot = false;
+
+    for (uint32_t scanned = 0; scanned < SCAN_LIMIT; scanned++) {
+        int32_t lookahead = lexer->lookahead;
 
-    for (;;) {
         if (is_eof(lexer)) {
-            mark_end(lexer);
-            lexer->result_symbol = REGEX_COMMANDLIST_HEADER;
-            reset(scanner);
-            return true;
+            break;
         }
-        switch (ss)
-        {
-        case GENSEARCH:
-            switch (lexer->lookahead)
-            {
-            case 'I':
+
+        if (after_dot) {
+            // the character after a dot is consumed whatever it is, and can only start a segment
+            after_dot = false;
+            switch (lookahead | 0x20) {
             case 'i':
-                ss = INSSEARCH;
-                array_push(&scanner->word, lexer->lookahead);
-                consume(lexer);
+                segment = REGEX_DECLARATIONS_HEADER;
+                expected = "nsertdeclarations";
                 break;
-            case 'P':
             case 'p':
-                ss = PATSEARCH;
-                array_push(&scanner->word, lexer->lookahead);
-                consume(lexer);
+                segment = REGEX_PATTERN_HEADER;
+                expected = "attern";
                 break;
             default:
-                ss = NOTSEARCHING;
-                consume(lexer);
+                segment = REGEX_COMMANDLIST_HEADER;
                 break;
             }
-            break;
-        case INSSEARCH:
-        case REPSEARCH:
-            if (ss & 0x2) {
-                search_target = "replace";
-                result = REGEX_REPLACE_HEADER;
+        }
+        else if (lookahead == ']' || lookahead == '\n') {
+            mark_end(lexer);
+
+            if (segment != REGEX_COMMANDLIST_HEADER && *expected == '\0') {
+                if (!valid_symbols[segment]) return false;
+                lexer->result_symbol = segment;
+                return true;
+            }
+
+            lexer->result_symbol = REGEX_COMMANDLIST_HEADER;
+            return true;
+        }
+        else if (lookahead == '.') {
+            // a complete `.Pattern` may continue with `.Replace`, any other dot starts over
+            if (segment == REGEX_PATTERN_HEADER && *expected == '\0') {
+                segment = REGEX_REPLACE_HEADER;
+                expected = "replace";
+            }
+            else {
+                segment = REGEX_COMMANDLIST_HEADER;
+                after_dot = true;
+            }
+        }
+        else if (segment != REGEX_COMMANDLIST_HEADER) {
+            // only ASCII letters occur in the suffixes, so folding the 0x20 bit cannot alias any other character
+            if (*expected != '\0' && (lookahead | 0x20) == *expected) {
+                expected++;
             }
             else {
-                search_target = "insertdeclarations";
-                result = REGEX_DECLARATIONS_HEADER;
+                segment = REGEX_COMMANDLIST_HEADER;
             }
+        }
 
-            switch (lexer->lookahead)
-            {
-            case ']':
-            case '\n':
-                mark_end(lexer);
+        consume(lexer);
+    }
+
+    if (!is_eof(lexer)) {
+        return false;
+    }
+
+    mark_end(lexer);
+    lexer->result_symbol = REGEX_COMMANDLIST_HEADER;
+    return true;
+}
 
-                array_push(&scanner->word, '\0'); // terminate the accumulated word
+#define TOKEN_BIT(token) (1u << (token))
+#define TOKEN_BITS(first, last) ((TOKEN_BIT(last) << 1) - TOKEN_BIT(first))
 
-                strlwr(scanner->word.contents);
+_Static_assert(ERROR_SENTINEL < 32, "the valid external tokens must fit in one word");
 
-                if (!strcmp(scanner->word.contents, search_target)) {
-                    reset(scanner);
-                    if (!valid_symbols[result]) return false;
-                    lexer->result_symbol = result;
-                    return true;
-                }
+// The tokens each of the scans below searches for
+enum {
+    NAMESPACE_BITS = TOKEN_BITS(NAMESPACE_RESOLUTION_START, NAMESPACE_RESOLUTION_END),
+    // Key, Preset, Resource[^\]]+, Include[^\]]* and (?:ShaderOverride|TextureOverride|(?:BuiltIn)?(?:CommandList|CustomShader))[^\]]+
+    SUFFIXED_HEADER_BITS = TOKEN_BITS(SUFFIXED_KEY_HEADER, SUFFIXED_COMMANDLIST_HEADER),
+    // the ShaderRegex prefix is only ever valid together with the others, which decide it
+    HEADER_PREFIX_BITS = TOKEN_BITS(KEY_HEADER_PREFIX, CUSTOMRESOURCE_HEADER_PREFIX) & ~TOKEN_BIT(REGEX_HEADER_PREFIX),
+    REGEX_HEADER_BITS = TOKEN_BITS(REGEX_COMMANDLIST_HEADER, REGEX_REPLACE_HEADER),
+    SECTION_HEADER_BITS = TOKEN_BITS(SECTION_HEADER_START, SECTION_HEADER_GUARD),
+};
 
-                ss = NOTSEARCHING;
-                reset(scanner);
-                break;
-            case '.':
-                mark_end(lexer);
-                ss = NOTSEARCHING;
-                reset(scanner);
-                break;
-            default:
-                array_push(&scanner->word, lexer->lookahead);
-                consume(lexer);
-                break;
-            }
-            break;
-        case PATSEARCH:
-            switch (lexer->lookahead)
-            {
-            case '.':
-            case ']':
-            case '\n':
-                mark_end(lexer);
-
-                array_push(&scanner->word, '\0'); // terminate the accumulated word
-
-                strlwr(scanner->word.contents);
-                
-                if (!strcmp(scanner->word.contents, "pattern")) {
-                    if (lexer->lookahead == '.') {
-                        ss = REPSEARCH;
-                        reset(scanner);
-                        consume(lexer);
-                    }
-                    else {
-                        reset(scanner);
-                        if (!valid_symbols[REGEX_PATTERN_HEADER]) {
-                            return false;
-                        }
-                        lexer->result_symbol = REGEX_PATTERN_HEADER;
-                        return true;
-                    }
-                }
-                else {
-                    lexer->result_symbol = REGEX_COMMANDLIST_HEADER;
-                    ss = NOTSEARCHING;
-                    reset(scanner);
-                }
-                break;
-            default:
-                array_push(&scanner->word, lexer->lookahead);
-                consume(lexer);
-                break;
-            }
-            break;
-        case NOTSEARCHING:
-        default:
-            switch (lexer->lookahead)
-            {
-            case ']':
-            case '\n':
-                mark_end(lexer);
-                lexer->result_symbol = REGEX_COMMANDLIST_HEADER;
-                return true;
-            case '.':
-                mark_end(lexer);
-                ss = GENSEARCH;
-                consume(lexer);
-                break;
-            default:
-                consume(lexer);
-                break;
-            }
-            break;
-        }
+/// Packs eight valid symbols into the bits of a byte: with each bool in its own byte of a little-endian word, the
+/// multiplication adds every byte's bit into a distinct position of the top byte.
+static inline uint32_t pack_valid_symbols(const bool *valid_symbols) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    uint32_t bits = 0;
+    for (uint32_t t = 0; t < 8; t++) {
+        bits |= (uint32_t)valid_symbols[t] << t;
+    }
+    return bits;
+#else
+    uint64_t bytes;
+    memcpy(&bytes, valid_symbols, sizeof(bytes));
+    return (uint32_t)((bytes * 0x0102040810204080ull) >> 56);
+#endif
+}
+
+/// Packs the valid symbols into a word, so that each scan is picked by a single test of its tokens' bits
+static inline uint32_t valid_token_bits(const bool *valid_symbols) {
+    uint32_t bits = pack_valid_symbols(valid_symbols) |
+        pack_valid_symbols(valid_symbols + 8) << 8 |
+        pack_valid_symbols(valid_symbols + 16) << 16;
+
+    for (uint32_t t = 24; t <= ERROR_SENTINEL; t++) {
+        bits |= (uint32_t)valid_symbols[t] << t;
     }
+    return bits;
 }
 
-bool tree_sitter_migoto_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols) {
+/// The lowest numbered token of a nonempty set
+static inline TokenType first_token(uint32_t bits) {
+    uint32_t t = 0;
+    while (!(bits & TOKEN_BIT(t))) t++;
+    return (TokenType)t;
+}
+
+static inline bool scan(TSLexer *lexer, const bool *valid_symbols) {
     if (valid_symbols[ERROR_SENTINEL]) {
-        return false;
+        STATS_SEARCH(ERROR_SENTINEL, ERROR_SENTINEL);
+        uint32_t resume_column = indented_column;
+        indented_column = NO_COLUMN;
+        return scan_malformed_line(lexer, resume_column);
     }
 
+    // every token but the indentation taken during error recovery serializes to nothing
+    indented_column = NO_COLUMN;
+
+    // by far the most common request, answered before looking at any other token
     if (valid_symbols[NEWLINE]) {
+        STATS_SEARCH(NEWLINE, NEWLINE);
         return scan_end_of_line(lexer);
     }
 
     // From tree-sitter-zig github PR#10, under MIT license
     if (valid_symbols[DOC_COMMENT_CONTENT]) {
+        STATS_SEARCH(DOC_COMMENT_CONTENT, DOC_COMMENT_CONTENT);
         lexer->result_symbol = DOC_COMMENT_CONTENT;
-        while (true) {
-            if (is_eof(lexer)) {
-                return true;
-            }
-
-            if (lexer->lookahead == '\n') {
-                // including the line ending in doc
-                // comments is necessary for markdown injections
-                consume(lexer);
-                return true;
-            }
-
+        // including the line ending in doc
+        // comments is necessary for markdown injections
+        consume_line(lexer);
+        if (lexer->lookahead == '\n') {
             consume(lexer);
         }
+        return true;
     }
 
-    if (valid_symbols[NAMESPACE_RESOLUTION_START]) {
-        return scan_namespace_res_start_end(lexer, NAMESPACE_RESOLUTION_START);
+    uint32_t valid = valid_token_bits(valid_symbols);
+
+    if (valid & NAMESPACE_BITS) {
+        TokenType t = first_token(valid & NAMESPACE_BITS);
+        STATS_SEARCH(t, t);
+
+        if (t == NAMESPACE_RESOLUTION_CONTENT) {
+            return scan_namespace_res_content(lexer);
+        }
+
+        return scan_namespace_res_start_end(lexer, t);
     }
 
-    if (valid_symbols[NAMESPACE_RESOLUTION_CONTENT]) {
-        return scan_namespace_res_content(lexer);
+    if (valid & SUFFIXED_HEADER_BITS) {
+        STATS_SEARCH(SUFFIXED_KEY_HEADER, SUFFIXED_COMMANDLIST_HEADER);
+        return scan_suffixed_section_header(lexer, first_token(valid & SUFFIXED_HEADER_BITS), valid_symbols);
     }
 
-    if (valid_symbols[NAMESPACE_RESOLUTION_END]) {
-        return scan_namespace_res_start_end(lexer, NAMESPACE_RESOLUTION_END);
+    if (valid & HEADER_PREFIX_BITS) {
+        STATS_SEARCH(KEY_HEADER_PREFIX, CUSTOMRESOURCE_HEADER_PREFIX);
+        return scan_section_header_prefix(lexer, valid_symbols, true);
     }
 
-    if (valid_symbols[SUFFIXED_KEY_HEADER] || valid_symbols[SUFFIXED_PRESET_HEADER] ||
-        valid_symbols[SUFFIXED_RESOURCE_HEADER] || valid_symbols[SUFFIXED_INCLUDE_HEADER] ||
-        valid_symbols[SUFFIXED_COMMANDLIST_HEADER])
-    {
-        TokenType t = ERROR_SENTINEL;
+    if (valid & REGEX_HEADER_BITS) {
+        STATS_SEARCH(REGEX_COMMANDLIST_HEADER, REGEX_REPLACE_HEADER);
+        return scan_for_regex_suffix(lexer, valid_symbols);
+    }
 
-        if (valid_symbols[SUFFIXED_KEY_HEADER])
-            t = SUFFIXED_KEY_HEADER;
-        else if (valid_symbols[SUFFIXED_PRESET_HEADER])
-            t = SUFFIXED_PRESET_HEADER;
-        else if (valid_symbols[SUFFIXED_RESOURCE_HEADER])
-            t = SUFFIXED_RESOURCE_HEADER;
-        else if (valid_symbols[SUFFIXED_INCLUDE_HEADER])
-            t = SUFFIXED_INCLUDE_HEADER;
-        else if (valid_symbols[SUFFIXED_COMMANDLIST_HEADER])
-            t = SUFFIXED_COMMANDLIST_HEADER;
+    if (valid & SECTION_HEADER_BITS) {
+        STATS_SEARCH(SECTION_HEADER_START, SECTION_HEADER_GUARD);
+        return scan_section_header_lookahead(lexer, valid_symbols);
+    }
 
-        return scan_suffixed_section_header(lexer, t, valid_symbols);
+    if (valid & TOKEN_BIT(EXTERNAL_LINE)) {
+        STATS_SEARCH(EXTERNAL_LINE, EXTERNAL_LINE);
+        return scan_line(lexer, valid_symbols);
     }
 
-    Scanner *scanner = (Scanner*) payload;
-    bool is_prefix_search = (
-        valid_symbols[KEY_HEADER_PREFIX] || valid_symbols[PRESET_HEADER_PREFIX] ||
-        valid_symbols[INCLUDE_HEADER_PREFIX] || valid_symbols[COMMANDLIST_HEADER_PREFIX] ||
-        valid_symbols[COMMANDLIST_CALLABLE_PREFIX] || valid_symbols[CUSTOMSHADER_CALLABLE_PREFIX] ||
-        valid_symbols[CUSTOMRESOURCE_HEADER_PREFIX]
-    );
+    return false;
+}
 
-    if (is_prefix_search) {
-        return scan_section_header_prefix(scanner, lexer, valid_symbols, is_prefix_search);
-    }
+bool tree_sitter_migoto_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols) {
+    (void)payload;
 
-    if (valid_symbols[REGEX_COMMANDLIST_HEADER] || valid_symbols[REGEX_DECLARATIONS_HEADER] ||
-        valid_symbols[REGEX_PATTERN_HEADER] || valid_symbols[REGEX_REPLACE_HEADER])
-    {
-        return scan_for_regex_suffix(scanner, lexer, valid_symbols);
-    }
+#ifdef TREE_SITTER_MIGOTO_SCANNER_STATS
+    stats_token = ERROR_SENTINEL;
+    bool found = scan(lexer, valid_symbols);
 
-    if (valid_symbols[EXTERNAL_LINE] && !(valid_symbols[SECTION_HEADER_START] || valid_symbols[SECTION_HEADER_GUARD])) {
-        return scan_line(scanner, lexer, valid_symbols);
+    scanner_stats[stats_token].invocations++;
+    if (found) {
+        scanner_stats[lexer->result_symbol].successes++;
     }
 
-    if (valid_symbols[SECTION_HEADER_START] || valid_symbols[SECTION_HEADER_GUARD]) {
-        return scan_section_header_lookahead(scanner, lexer, valid_symbols);
+    return found;
+#else
+    return scan(lexer, valid_symbols);
+#endif
+}
+
+#ifdef TREE_SITTER_MIGOTO_SCANNER_STATS
+uint32_t tree_sitter_migoto_scanner_stats(TSMigotoScannerStats *stats, uint32_t count) {
+    uint32_t token_count = ERROR_SENTINEL + 1;
+
+    for (uint32_t i = 0; i < count && i < token_count; i++) {
+        stats[i] = scanner_stats[i];
+        stats[i].name = TOKEN_NAMES[i];
     }
 
-    return false;
+    return token_count;
+}
+
+void tree_sitter_migoto_scanner_stats_reset(void) {
+    for (uint32_t i = 0; i < ERROR_SENTINEL + 1; i++) {
+        scanner_stats[i] = (TSMigotoScannerStats){0};
+    }
 }
+#endif
@@ -0,0 +1,66 @@
+// Generated from the externals list in grammar.js by cmake/GenerateScannerTokens.cmake, do not edit
+
+#ifndef TREE_SITTER_MIGOTO_SCANNER_TOKENS_H_
+#define TREE_SITTER_MIGOTO_SCANNER_TOKENS_H_
+
+typedef enum {
+    EXTERNAL_LINE,
+    SECTION_HEADER_START,
+    SECTION_HEADER_GUARD,
+    KEY_HEADER_PREFIX,
+    REGEX_HEADER_PREFIX,
+    PRESET_HEADER_PREFIX,
+    INCLUDE_HEADER_PREFIX,
+    COMMANDLIST_HEADER_PREFIX,
+    COMMANDLIST_CALLABLE_PREFIX,
+    CUSTOMSHADER_CALLABLE_PREFIX,
+    CUSTOMRESOURCE_HEADER_PREFIX,
+    NAMESPACE_RESOLUTION_START,
+    NAMESPACE_RESOLUTION_CONTENT,
+    NAMESPACE_RESOLUTION_END,
+    SUFFIXED_KEY_HEADER,
+    SUFFIXED_PRESET_HEADER,
+    SUFFIXED_RESOURCE_HEADER,
+    SUFFIXED_INCLUDE_HEADER,
+    SUFFIXED_COMMANDLIST_HEADER,
+    REGEX_COMMANDLIST_HEADER,
+    REGEX_DECLARATIONS_HEADER,
+    REGEX_PATTERN_HEADER,
+    REGEX_REPLACE_HEADER,
+    NEWLINE,
+    DOC_COMMENT_CONTENT,
+    ERROR_SENTINEL,
+} TokenType;
+
+#ifdef TREE_SITTER_MIGOTO_SCANNER_STATS
+static const char *const TOKEN_NAMES[] = {
+    "_external_line",
+    "_section_header_start",
+    "_section_header_guard",
+    "_key_header_prefix",
+    "_regex_header_prefix",
+    "_preset_header_prefix",
+    "_include_header_prefix",
+    "_commandlist_header_prefix",
+    "_commandlist_callable_prefix",
+    "_customshader_callable_prefix",
+    "_customresource_header_prefix",
+    "_namespace_resolution_start",
+    "_namespace_resolution_content",
+    "_namespace_resolution_end",
+    "_suffixed_key_header",
+    "_suffixed_preset_header",
+    "_suffixed_resource_header",
+    "_suffixed_include_header",
+    "_suffixed_commandlist_header",
+    "_regex_commandlist_header",
+    "_regex_declarations_header",
+    "_regex_pattern_header",
+    "_regex_replace_header",
+    "_newline",
+    "doc_comment_content",
+    "error_sentinel",
+};
+#endif
+
+#endif // TREE_SITTER_MIGOTO_SCANNER_TOKENS_H_
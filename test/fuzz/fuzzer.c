@@ -0,0 +1,68 @@
+/// libFuzzer target for the migoto parser and its external scanner.
+///
+/// Besides crashes, any input that takes longer than MIGOTO_FUZZ_MAX_NS_PER_BYTE nanoseconds per byte to parse
+/// (default 50000) is reported as a failure, so libFuzzer saves it as an artifact. Inputs shorter than
+/// MIGOTO_FUZZ_MIN_BYTES (default 1024) are exempt, since their timings are mostly noise.
+/// Slow inputs found this way belong in test/fuzz/regressions, which the `fuzz-regressions` test replays.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "tree_sitter/tree-sitter-migoto.h"
+
+#include <tree_sitter/api.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static TSParser *parser;
+static uint64_t max_ns_per_byte = 50000;
+static size_t min_bytes = 1024;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t env_or(const char *name, uint64_t fallback) {
+    const char *value = getenv(name);
+    return (value && *value) ? strtoull(value, NULL, 10) : fallback;
+}
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+
+    max_ns_per_byte = env_or("MIGOTO_FUZZ_MAX_NS_PER_BYTE", max_ns_per_byte);
+    min_bytes = (size_t)env_or("MIGOTO_FUZZ_MIN_BYTES", min_bytes);
+
+    parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_migoto())) {
+        fprintf(stderr, "migoto-fuzzer: language version mismatch with the tree-sitter runtime\n");
+        abort();
+    }
+
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    uint64_t start = now_ns();
+    TSTree *tree = ts_parser_parse_string(parser, NULL, (const char *)data, (uint32_t)size);
+    uint64_t elapsed = now_ns() - start;
+
+    // walking the root keeps the whole tree reachable for the sanitizers
+    TSNode root = ts_tree_root_node(tree);
+    (void)ts_node_child_count(root);
+    ts_tree_delete(tree);
+
+    if (size >= min_bytes && elapsed / size > max_ns_per_byte) {
+        fprintf(stderr, "migoto-fuzzer: slow input, %zu bytes parsed in %llu ns (%llu ns/byte, limit %llu)\n",
+                size, (unsigned long long)elapsed, (unsigned long long)(elapsed / size),
+                (unsigned long long)max_ns_per_byte);
+        abort();
+    }
+
+    return 0;
+}
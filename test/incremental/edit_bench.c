@@ -0,0 +1,225 @@
+/// Incremental-edit benchmark: how many bytes tree-sitter re-lexes after a single-character edit.
+///
+/// A large ini is parsed once. Then, at evenly spaced positions, one character is typed into a copy of that tree
+/// and the document is reparsed against it. The input is served one byte per read, so every byte the lexer touches
+/// during the reparse is seen and counted once. Bytes in reused subtrees are never read. The report gives the
+/// distinct bytes read per edit, which is mostly decided by how far tokens look ahead past their own end.
+///
+/// Usage: migoto-edit-bench [file.ini] [edits]
+///   file.ini  the document to edit, by default a generated one of about 1 MB
+///   edits     the number of edit positions, 200 by default
+
+#include "tree_sitter/tree-sitter-migoto.h"
+
+#include <tree_sitter/api.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GENERATED_SIZE (1024 * 1024)
+
+typedef struct {
+    const char *text;
+    uint32_t length;
+    uint8_t *seen;      // one flag per byte, set when the lexer reads it
+    uint32_t distinct;  // bytes read at least once
+    uint64_t reads;     // every read, including bytes read again after backtracking
+} CountingInput;
+
+static const char *read_byte(void *payload, uint32_t byte, TSPoint position, uint32_t *bytes_read) {
+    (void)position;
+    CountingInput *input = payload;
+    if (byte >= input->length) {
+        *bytes_read = 0;
+        return "";
+    }
+
+    input->reads++;
+    if (!input->seen[byte]) {
+        input->seen[byte] = 1;
+        input->distinct++;
+    }
+    *bytes_read = 1;
+    return input->text + byte;
+}
+
+static TSTree *parse(TSParser *parser, TSTree *old_tree, CountingInput *input) {
+    memset(input->seen, 0, input->length);
+    input->distinct = 0;
+    input->reads = 0;
+
+    TSInput ts_input = {
+        .payload = input,
+        .read = read_byte,
+        .encoding = TSInputEncodingUTF8,
+    };
+    return ts_parser_parse(parser, old_tree, ts_input);
+}
+
+// one of each kind of section, formatted with the number of the part it belongs to
+#define DOCUMENT_PART \
+    "[Constants]\n" \
+    "global persist $active_%u = 1\n" \
+    "global $cycle_%u = 0\n" \
+    "\n" \
+    "; Cycles the outfit of part %u\n" \
+    "[KeyCycle%u]\n" \
+    "condition = $active_%u == 1\n" \
+    "key = VK_F%u\n" \
+    "type = cycle\n" \
+    "$cycle_%u = 0, 1, 2\n" \
+    "\n" \
+    "[TextureOverrideBody%u]\n" \
+    "hash = %08x\n" \
+    "match_first_index = %u\n" \
+    "if $cycle_%u == 1 && $active_%u\n" \
+    "  ib = ResourceBodyIB%u\n" \
+    "  ps-t0 = ResourceBodyDiffuse%u\n" \
+    "else if $cycle_%u == 2\n" \
+    "  run = CommandListBody%u\n" \
+    "endif\n" \
+    "drawindexed = auto\n" \
+    "\n" \
+    "[CommandListBody%u]\n" \
+    "vb0 = ResourceBodyPosition%u\n" \
+    "$\\mods\\shared\\outfit = $cycle_%u\n" \
+    "\n" \
+    "[ResourceBodyIB%u]\n" \
+    "type = Buffer\n" \
+    "format = DXGI_FORMAT_R32_UINT\n" \
+    "filename = Body%u.ib\n" \
+    "\n" \
+    "[ResourceBodyData%u]\n" \
+    "type = Buffer\n" \
+    "data = R32_FLOAT 0.25 0.90 0.25 0.80 1.00 1.00 1.00 1.00 0.00 0.00 0.00 0.80\n" \
+    "\n" \
+    "[ShaderRegexBody%u]\n" \
+    "shader_model = ps_5_0\n" \
+    "run = CommandListBody%u\n" \
+    "\n" \
+    "[ShaderRegexBody%u.Pattern]\n" \
+    "mul r0.xyzw, cb0[12].xyzw, v0.xxxx\n" \
+    "add r1.xyz, cb1[3].xyz, -cb15[3].xyz\n" \
+    "\n"
+
+/// Repeats DOCUMENT_PART with distinct names until the document reaches `size` bytes
+static char *generate_document(uint32_t size, uint32_t *length) {
+    char *document = malloc(size + 4096);
+    uint32_t used = 0;
+
+    for (uint32_t part = 0; used < size; part++) {
+        used += (uint32_t)snprintf(document + used, 4096, DOCUMENT_PART,
+                                   part, part, part, part, part, part % 12 + 1, part, part, part * 2654435761u, part,
+                                   part, part, part, part, part, part, part, part, part, part, part, part, part,
+                                   part, part);
+    }
+
+    *length = used;
+    return document;
+}
+
+static char *read_file(const char *path, uint32_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *text = malloc((size_t)size + 1);
+    *length = (uint32_t)fread(text, 1, (size_t)size, file);
+    fclose(file);
+    return text;
+}
+
+static TSPoint point_at(const char *text, uint32_t byte) {
+    TSPoint point = {0, 0};
+    for (uint32_t i = 0; i < byte; i++) {
+        if (text[i] == '\n') {
+            point.row++;
+            point.column = 0;
+        }
+        else {
+            point.column++;
+        }
+    }
+    return point;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    uint32_t length = 0;
+    char *text = argc > 1 ? read_file(argv[1], &length) : generate_document(GENERATED_SIZE, &length);
+    uint32_t edits = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 200;
+
+    if (!text || length == 0 || edits == 0) {
+        fprintf(stderr, "usage: migoto-edit-bench [file.ini] [edits]\n");
+        return EXIT_FAILURE;
+    }
+
+    TSParser *parser = ts_parser_new();
+    if (!ts_parser_set_language(parser, tree_sitter_migoto())) {
+        fprintf(stderr, "migoto-edit-bench: language version mismatch with the tree-sitter runtime\n");
+        return EXIT_FAILURE;
+    }
+
+    CountingInput input = {text, length, malloc(length + 1), 0, 0};
+    TSTree *tree = parse(parser, NULL, &input);
+    printf("%u bytes, initial parse read %u bytes\n", length, input.distinct);
+
+    char *edited = malloc(length + 1);
+    uint32_t *relexed = malloc(edits * sizeof(uint32_t));
+    uint64_t total_reads = 0;
+
+    for (uint32_t i = 0; i < edits; i++) {
+        // type one character, as an editor would send it
+        uint32_t byte = (uint32_t)((uint64_t)length * i / edits);
+        memcpy(edited, text, byte);
+        edited[byte] = 'x';
+        memcpy(edited + byte + 1, text + byte, length - byte);
+
+        TSPoint start = point_at(text, byte);
+        TSInputEdit edit = {
+            .start_byte = byte,
+            .old_end_byte = byte,
+            .new_end_byte = byte + 1,
+            .start_point = start,
+            .old_end_point = start,
+            .new_end_point = {start.row, start.column + 1},
+        };
+
+        TSTree *copy = ts_tree_copy(tree);
+        ts_tree_edit(copy, &edit);
+
+        CountingInput edited_input = {edited, length + 1, malloc(length + 2), 0, 0};
+        TSTree *reparsed = parse(parser, copy, &edited_input);
+        relexed[i] = edited_input.distinct;
+        total_reads += edited_input.reads;
+
+        ts_tree_delete(reparsed);
+        ts_tree_delete(copy);
+        free(edited_input.seen);
+    }
+
+    qsort(relexed, edits, sizeof(uint32_t), compare_u32);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < edits; i++) sum += relexed[i];
+
+    printf("%u single-character edits, bytes re-lexed per edit: mean %.1f, median %u, p90 %u, max %u\n",
+           edits, (double)sum / edits, relexed[edits / 2], relexed[edits * 9 / 10], relexed[edits - 1]);
+    printf("reads per edit, counting bytes read more than once: %.1f\n", (double)total_reads / edits);
+
+    free(relexed);
+    free(edited);
+    free(input.seen);
+    ts_tree_delete(tree);
+    ts_parser_delete(parser);
+    free(text);
+    return EXIT_SUCCESS;
+}
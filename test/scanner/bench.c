@@ -0,0 +1,349 @@
+/// Microbenchmark and token checks for the external scanner, driven through the mock lexer without a parser.
+///
+/// Each case asks the scanner for one family of external tokens, the way a parse state would, at the start of
+/// every sample in a large buffer. Every sample first has its result checked against the expected token, then the
+/// case is timed and reported in nanoseconds per byte the scanner read and per call.
+///
+/// Usage: migoto-scanner-bench [--check]
+///   --check  only check the samples, for use as a test
+
+#include "mock_lexer.h"
+#include "scanner_tokens.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *tree_sitter_migoto_external_scanner_create(void);
+void tree_sitter_migoto_external_scanner_destroy(void *payload);
+bool tree_sitter_migoto_external_scanner_scan(void *payload, TSLexer *lexer, const bool *valid_symbols);
+unsigned tree_sitter_migoto_external_scanner_serialize(void *payload, char *buffer);
+void tree_sitter_migoto_external_scanner_deserialize(void *payload, const char *buffer, unsigned length);
+
+#define NO_TOKEN -1
+#define MAX_VALID 8
+#define MAX_SAMPLES 8
+
+// samples are repeated until a case has this many calls
+#define CALLS_PER_CASE 60000
+#define TRIALS 7
+
+typedef struct {
+    const char *text; // the scan starts at its first character
+    int expected;     // the token the scanner must return, or NO_TOKEN if it must find none
+} Sample;
+
+typedef struct {
+    const char *name;
+    int valid[MAX_VALID]; // the valid tokens, ended by NO_TOKEN
+    Sample samples[MAX_SAMPLES];
+} Case;
+
+static const Case CASES[] = {
+    {"_external_line", {EXTERNAL_LINE, NO_TOKEN}, {
+        {"(?<Tillo2Pick>.*movc o2\\.z, (?<o2Pick>r\\d\\.[xyzw]+, r\\d\\.[xyzw]+, r\\d\\.[xyzw]+))\n", EXTERNAL_LINE},
+        {"  mul r0.xyzw, cb0[12].xyzw, v0.xxxx\n", EXTERNAL_LINE},
+        {"ret\n", EXTERNAL_LINE},
+        {"\n[ShaderRegexNext.Pattern]\n", NO_TOKEN},
+    }},
+    {"_section_header_start/guard", {SECTION_HEADER_START, SECTION_HEADER_GUARD, NO_TOKEN}, {
+        {"\nif_z r0.x\n", SECTION_HEADER_GUARD},
+        {"\n\t  add r1.xyz, cb1[3].xyz, -cb15[3].xyz\n", SECTION_HEADER_GUARD},
+        {"\n\n[Present]\n", SECTION_HEADER_START},
+        {"\n\n  mov r0.x, l(1.0)\n[Present]\n", SECTION_HEADER_GUARD},
+        {"\n; a comment\n", NO_TOKEN},
+    }},
+    {"section header prefixes", {KEY_HEADER_PREFIX, REGEX_HEADER_PREFIX, PRESET_HEADER_PREFIX, INCLUDE_HEADER_PREFIX,
+                                 COMMANDLIST_HEADER_PREFIX, CUSTOMRESOURCE_HEADER_PREFIX, NO_TOKEN}, {
+        {"KeyCycleOutfit]\n", KEY_HEADER_PREFIX},
+        {"ShaderRegexBody.Pattern]\n", REGEX_HEADER_PREFIX},
+        {"TextureOverrideBodyIB]\n", COMMANDLIST_HEADER_PREFIX},
+        {"CustomShaderBlend]\n", COMMANDLIST_HEADER_PREFIX},
+        {"PresetSwimsuit]\n", PRESET_HEADER_PREFIX},
+        {"ResourceBodyDiffuse]\n", CUSTOMRESOURCE_HEADER_PREFIX},
+        {"Constants]\n", NO_TOKEN},
+    }},
+    {"callable prefixes", {COMMANDLIST_CALLABLE_PREFIX, CUSTOMSHADER_CALLABLE_PREFIX, NO_TOKEN}, {
+        {"CommandListSetTextures\n", COMMANDLIST_CALLABLE_PREFIX},
+        {"CustomShaderBlendOutline\n", CUSTOMSHADER_CALLABLE_PREFIX},
+        {"BuiltInCommandListUnbindAll\n", COMMANDLIST_CALLABLE_PREFIX},
+    }},
+    {"_namespace_resolution_content", {NAMESPACE_RESOLUTION_CONTENT, NO_TOKEN}, {
+        {"mods\\shared\\outfit == 1\n", NAMESPACE_RESOLUTION_CONTENT},
+        {"Mods\\Character Pack\\merged.ini\\swapvar, $next\n", NAMESPACE_RESOLUTION_CONTENT},
+        {"ns\\A, CommandList\\ns\\B\n", NAMESPACE_RESOLUTION_CONTENT},
+        {"unclosed = 1\n", NO_TOKEN},
+    }},
+    {"_suffixed_commandlist_header", {SUFFIXED_COMMANDLIST_HEADER, NO_TOKEN}, {
+        {"BodyIB]\n", SUFFIXED_COMMANDLIST_HEADER},
+        {"Character Pack Body Layer 1 ]\n", SUFFIXED_COMMANDLIST_HEADER},
+        {"   ]\n", NO_TOKEN},
+    }},
+    {"ShaderRegex suffixes", {REGEX_COMMANDLIST_HEADER, REGEX_DECLARATIONS_HEADER, REGEX_PATTERN_HEADER,
+                              REGEX_REPLACE_HEADER, NO_TOKEN}, {
+        {"Mod.Body.Skin.Layer1.Layer2.Pattern.Replace]\n", REGEX_REPLACE_HEADER},
+        {"Mod.Body.Skin.Layer1.Layer2.InsertDeclarations]\n", REGEX_DECLARATIONS_HEADER},
+        {"Mod.Outfit.v2.1.Hair.Pattern]\n", REGEX_PATTERN_HEADER},
+        {"Mod.Outfit.v2.1.Hair.Pattern.Rep.Extra]\n", REGEX_COMMANDLIST_HEADER},
+        {"Mod.Parts.Pants.Pixel.Shaders.Fix]\n", REGEX_COMMANDLIST_HEADER},
+    }},
+    {"_newline", {NEWLINE, NO_TOKEN}, {
+        {"\n", NEWLINE},
+        {"   \t\n", NEWLINE},
+        {"  = 1\n", NO_TOKEN},
+    }},
+    {"doc_comment_content", {DOC_COMMENT_CONTENT, NO_TOKEN}, {
+        {" # Outfit toggles\n", DOC_COMMENT_CONTENT},
+        {" Cycles through the **outfit** variants; see `$\\mods\\shared\\outfit` for the shared state.\n",
+         DOC_COMMENT_CONTENT},
+        {" - `1`: default, `2`: swimsuit, `3`: winter coat (requires the *Seasons* pack)\n", DOC_COMMENT_CONTENT},
+    }},
+};
+
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+/// A scan during error recovery, where the parser asks for every external token. Most start partway into their
+/// line, after the text the parser could not use.
+typedef struct {
+    const char *line;
+    uint32_t start; // the byte of line the scan starts at
+    uint32_t end;   // where the error_sentinel token taking the rest of the line and the indentation of the next one
+                    // must end, or 0 if there must be none
+} RecoverySample;
+
+static const RecoverySample RECOVERY_SAMPLES[] = {
+    {"if$var == 0 && $active\n", 2, 23},
+    {"elifps-t0 === 0\n", 6, 16},
+    {"hash = = 12345678 ; the hash of the body IB\r\n", 7, 45},
+    {"$var = 1   \n", 8, 12},
+    {"if$var == 0\n  $var = 1\n  endif\n", 2, 14},
+    {"elifps-t0 === 0\n\n\t; a comment\n", 6, 18},
+    {"\n  \n\t\tdrawindexed = auto\n", 0, 6},
+    {"  [TextureOverrideBody]\n", 2, 0},
+    {"endif\n", 0, 0},
+};
+
+#define RECOVERY_SAMPLE_COUNT (sizeof(RECOVERY_SAMPLES) / sizeof(RECOVERY_SAMPLES[0]))
+
+typedef struct {
+    uint8_t *input;
+    uint32_t length;
+    uint32_t *starts;
+    const Sample **samples;
+    uint32_t count;
+} Buffer;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t sample_count(const Case *c) {
+    uint32_t count = 0;
+    while (count < MAX_SAMPLES && c->samples[count].text) count++;
+    return count;
+}
+
+/// Lays the samples of a case out back to back, repeated until there is one per call
+static Buffer buffer_new(const Case *c) {
+    uint32_t samples = sample_count(c);
+    Buffer buffer = {0};
+    size_t capacity = 0;
+
+    for (uint32_t i = 0; i < samples; i++) capacity += strlen(c->samples[i].text);
+    capacity = capacity * (CALLS_PER_CASE / samples + 1);
+
+    buffer.input = malloc(capacity);
+    buffer.starts = malloc(CALLS_PER_CASE * sizeof(uint32_t));
+    buffer.samples = malloc(CALLS_PER_CASE * sizeof(Sample *));
+
+    for (uint32_t i = 0; i < CALLS_PER_CASE; i++) {
+        const Sample *sample = &c->samples[i % samples];
+        size_t size = strlen(sample->text);
+        buffer.starts[i] = buffer.length;
+        buffer.samples[i] = sample;
+        memcpy(buffer.input + buffer.length, sample->text, size);
+        buffer.length += (uint32_t)size;
+    }
+    buffer.count = CALLS_PER_CASE;
+
+    return buffer;
+}
+
+static void buffer_delete(Buffer *buffer) {
+    free(buffer->input);
+    free(buffer->starts);
+    free(buffer->samples);
+}
+
+/// Whether a token must be decided without reading past the newline of the line it ends on, so that an edit to
+/// the next line leaves it valid
+static bool stays_on_its_line(int token) {
+    return token == NEWLINE || token == EXTERNAL_LINE || token == SECTION_HEADER_START || token == SECTION_HEADER_GUARD;
+}
+
+/// Whether a token must end within the reference it starts in, never taking the next one of a comma-separated list
+static bool stays_in_its_reference(int token) {
+    return token == NAMESPACE_RESOLUTION_CONTENT;
+}
+
+/// Offset of the first newline at or after `offset`, or the length of the text if there is none
+static uint32_t line_end(const char *text, uint32_t offset) {
+    const char *newline = strchr(text + offset, '\n');
+    return newline ? (uint32_t)(newline - text) : (uint32_t)strlen(text);
+}
+
+/// Where the token's line is found from: a zero-width token may skip whitespace after marking its end
+static uint32_t token_line_start(const MockLexer *mock) {
+    uint32_t end = mock_lexer_token_end(mock);
+    return mock->token_start < end ? mock->token_start : end;
+}
+
+static void valid_symbols_for(const Case *c, bool *valid_symbols) {
+    memset(valid_symbols, 0, sizeof(bool) * (ERROR_SENTINEL + 1));
+    for (uint32_t i = 0; i < MAX_VALID && c->valid[i] != NO_TOKEN; i++) {
+        valid_symbols[c->valid[i]] = true;
+    }
+}
+
+/// Checks every distinct sample of a case, returning the number of wrong results
+static uint32_t check_case(void *scanner, const Case *c) {
+    bool valid_symbols[ERROR_SENTINEL + 1];
+    valid_symbols_for(c, valid_symbols);
+
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < sample_count(c); i++) {
+        const Sample *sample = &c->samples[i];
+        MockLexer mock;
+        mock_lexer_init(&mock, (const uint8_t *)sample->text, (uint32_t)strlen(sample->text), 0);
+
+        bool found = tree_sitter_migoto_external_scanner_scan(scanner, &mock.lexer, valid_symbols);
+        int result = found ? mock.lexer.result_symbol : NO_TOKEN;
+        if (result != sample->expected) {
+            fprintf(stderr, "%s: expected token %d but got %d for \"%s\"\n", c->name, sample->expected, result,
+                    sample->text);
+            failures++;
+        }
+        else if (found && stays_on_its_line(result) &&
+                 mock.position > line_end(sample->text, token_line_start(&mock))) {
+            fprintf(stderr, "%s: token %d read into the next line for \"%s\"\n", c->name, result, sample->text);
+            failures++;
+        }
+        else if (found && stays_in_its_reference(result) &&
+                 memchr(sample->text, ',', mock_lexer_token_end(&mock)) != NULL) {
+            fprintf(stderr, "%s: token %d read into the next reference for \"%s\"\n", c->name, result,
+                    sample->text);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+/// Checks that each malformed rest of line is taken whole and that the scan after it leaves the first token of the
+/// next line to the lexer, returning the number of wrong results
+static uint32_t check_recovery(void *scanner) {
+    bool valid_symbols[ERROR_SENTINEL + 1];
+    memset(valid_symbols, true, sizeof(valid_symbols));
+
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < RECOVERY_SAMPLE_COUNT; i++) {
+        const RecoverySample *sample = &RECOVERY_SAMPLES[i];
+        uint32_t length = (uint32_t)strlen(sample->line);
+        MockLexer mock;
+        mock_lexer_init(&mock, (const uint8_t *)sample->line, length, sample->start);
+
+        // as tree-sitter does, restore the state of the previous external token before every scan
+        tree_sitter_migoto_external_scanner_deserialize(scanner, NULL, 0);
+        bool found = tree_sitter_migoto_external_scanner_scan(scanner, &mock.lexer, valid_symbols);
+        uint32_t end = found ? mock_lexer_token_end(&mock) : 0;
+        if ((found && mock.lexer.result_symbol != ERROR_SENTINEL) || end != sample->end) {
+            fprintf(stderr, "error recovery: expected a token ending at %u but got %d ending at %u for \"%s\"\n",
+                    sample->end, found ? (int)mock.lexer.result_symbol : NO_TOKEN, end, sample->line);
+            failures++;
+            continue;
+        }
+        if (!found || end == length) {
+            continue;
+        }
+
+        char state[TREE_SITTER_SERIALIZATION_BUFFER_SIZE];
+        unsigned state_length = tree_sitter_migoto_external_scanner_serialize(scanner, state);
+        mock_lexer_init(&mock, (const uint8_t *)sample->line, length, end);
+        tree_sitter_migoto_external_scanner_deserialize(scanner, state, state_length);
+        if (tree_sitter_migoto_external_scanner_scan(scanner, &mock.lexer, valid_symbols)) {
+            fprintf(stderr, "error recovery: took the first token of the next line at %u for \"%s\"\n", end,
+                    sample->line);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static void bench_case(void *scanner, const Case *c) {
+    bool valid_symbols[ERROR_SENTINEL + 1];
+    valid_symbols_for(c, valid_symbols);
+
+    Buffer buffer = buffer_new(c);
+    double best = 1e30;
+    uint64_t bytes = 0;
+
+    for (int trial = 0; trial < TRIALS; trial++) {
+        bytes = 0;
+        double start = now();
+        for (uint32_t i = 0; i < buffer.count; i++) {
+            MockLexer mock;
+            mock_lexer_init(&mock, buffer.input, buffer.length, buffer.starts[i]);
+            tree_sitter_migoto_external_scanner_scan(scanner, &mock.lexer, valid_symbols);
+            bytes += mock.position - buffer.starts[i];
+        }
+        double elapsed = now() - start;
+        if (elapsed < best) best = elapsed;
+    }
+
+    printf("%-32s %8.2f ns/byte %8.1f ns/call\n", c->name, best * 1e9 / (double)bytes, best * 1e9 / buffer.count);
+    buffer_delete(&buffer);
+}
+
+/// The cost of advancing the mock lexer alone, which no scan can beat
+static void bench_lexer_floor(void) {
+    Buffer buffer = buffer_new(&CASES[0]);
+    double best = 1e30;
+
+    for (int trial = 0; trial < TRIALS; trial++) {
+        double start = now();
+        MockLexer mock;
+        mock_lexer_init(&mock, buffer.input, buffer.length, 0);
+        while (!mock.lexer.eof(&mock.lexer)) mock.lexer.advance(&mock.lexer, false);
+        double elapsed = now() - start;
+        if (elapsed < best) best = elapsed;
+    }
+
+    printf("%-32s %8.2f ns/byte\n", "(lexer floor)", best * 1e9 / buffer.length);
+    buffer_delete(&buffer);
+}
+
+int main(int argc, char **argv) {
+    bool check_only = argc > 1 && strcmp(argv[1], "--check") == 0;
+    void *scanner = tree_sitter_migoto_external_scanner_create();
+
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < CASE_COUNT; i++) {
+        failures += check_case(scanner, &CASES[i]);
+    }
+    failures += check_recovery(scanner);
+
+    if (failures > 0) {
+        fprintf(stderr, "%u wrong scanner results\n", failures);
+    }
+    else if (!check_only) {
+        bench_lexer_floor();
+        for (uint32_t i = 0; i < CASE_COUNT; i++) {
+            bench_case(scanner, &CASES[i]);
+        }
+    }
+
+    tree_sitter_migoto_external_scanner_destroy(scanner);
+    return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#ifndef TREE_SITTER_MIGOTO_MOCK_LEXER_H_
+#define TREE_SITTER_MIGOTO_MOCK_LEXER_H_
+
+#include "tree_sitter/parser.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/// An in-memory TSLexer over a UTF-8 buffer, so the external scanner can be driven without a parser.
+/// Like tree-sitter's own lexer it reports a lookahead of 0 at the end of input, moves the token start
+/// when skipping, and ends the token at the last mark_end, or where scanning stopped if there was none.
+typedef struct {
+    TSLexer lexer;
+    const uint8_t *input;
+    uint32_t length;
+    uint32_t position;      // byte offset of the lookahead
+    uint32_t next_position; // byte offset after the lookahead
+    uint32_t token_start;
+    uint32_t token_end;
+    bool end_marked;
+} MockLexer;
+
+static void mock_lexer_decode(MockLexer *mock) {
+    const uint8_t *s = mock->input + mock->position;
+    uint32_t left = mock->length - mock->position;
+
+    if (left == 0) {
+        mock->lexer.lookahead = 0;
+        mock->next_position = mock->position;
+        return;
+    }
+
+    uint32_t size = 1;
+    int32_t c = s[0];
+    if (c >= 0x80) {
+        if ((c & 0xE0) == 0xC0 && left >= 2) {
+            c = ((c & 0x1F) << 6) | (s[1] & 0x3F);
+            size = 2;
+        }
+        else if ((c & 0xF0) == 0xE0 && left >= 3) {
+            c = ((c & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+            size = 3;
+        }
+        else if ((c & 0xF8) == 0xF0 && left >= 4) {
+            c = ((c & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+            size = 4;
+        }
+        else {
+            c = 0xFFFD;
+        }
+    }
+
+    mock->lexer.lookahead = c;
+    mock->next_position = mock->position + size;
+}
+
+static void mock_lexer_advance(TSLexer *lexer, bool skip) {
+    MockLexer *mock = (MockLexer *)lexer;
+    if (mock->position >= mock->length) return;
+
+    mock->position = mock->next_position;
+    mock_lexer_decode(mock);
+    if (skip) mock->token_start = mock->position;
+}
+
+static void mock_lexer_mark_end(TSLexer *lexer) {
+    MockLexer *mock = (MockLexer *)lexer;
+    mock->token_end = mock->position;
+    mock->end_marked = true;
+}
+
+static uint32_t mock_lexer_get_column(TSLexer *lexer) {
+    MockLexer *mock = (MockLexer *)lexer;
+    uint32_t column = 0;
+    for (uint32_t i = mock->position; i > 0 && mock->input[i - 1] != '\n'; i--) column++;
+    return column;
+}
+
+static bool mock_lexer_is_at_included_range_start(const TSLexer *lexer) {
+    (void)lexer;
+    return false;
+}
+
+static bool mock_lexer_eof(const TSLexer *lexer) {
+    const MockLexer *mock = (const MockLexer *)lexer;
+    return mock->position >= mock->length;
+}
+
+static void mock_lexer_log(const TSLexer *lexer, const char *format, ...) {
+    (void)lexer;
+    (void)format;
+}
+
+/// Starts a token at byte `position` of `input`
+static inline void mock_lexer_init(MockLexer *mock, const uint8_t *input, uint32_t length, uint32_t position) {
+    memset(mock, 0, sizeof(*mock));
+    mock->lexer.advance = mock_lexer_advance;
+    mock->lexer.mark_end = mock_lexer_mark_end;
+    mock->lexer.get_column = mock_lexer_get_column;
+    mock->lexer.is_at_included_range_start = mock_lexer_is_at_included_range_start;
+    mock->lexer.eof = mock_lexer_eof;
+    mock->lexer.log = mock_lexer_log;
+    mock->input = input;
+    mock->length = length;
+    mock->position = position;
+    mock->token_start = position;
+    mock_lexer_decode(mock);
+}
+
+/// Byte offset where the scanned token ends
+static inline uint32_t mock_lexer_token_end(const MockLexer *mock) {
+    return mock->end_marked ? mock->token_end : mock->position;
+}
+
+#endif // TREE_SITTER_MIGOTO_MOCK_LEXER_H_